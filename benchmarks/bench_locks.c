@@ -0,0 +1,233 @@
+//////////////////////////////////////////////////////////////////////////////////////
+//                                                                                  //
+//  Copyright (c) 2016-2025 Leonardo Consoni <leonardojc@protonmail.com>            //
+//                                                                                  //
+//  This file is part of Simple Multithreading.                                     //
+//                                                                                  //
+//  Simple Multithreading is free software: you can redistribute it and/or modify   //
+//  it under the terms of the GNU Lesser General Public License as published        //
+//  by the Free Software Foundation, either version 3 of the License, or            //
+//  (at your option) any later version.                                             //
+//                                                                                  //
+//  Simple Multithreading is distributed in the hope that it will be useful,        //
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of                  //
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                    //
+//  GNU Lesser General Public License for more details.                             //
+//                                                                                  //
+//  You should have received a copy of the GNU Lesser General Public License        //
+//  along with Simple Multithreading. If not, see <http://www.gnu.org/licenses/>.   //
+//                                                                                  //
+//////////////////////////////////////////////////////////////////////////////////////
+
+// Acquisition latency of lock implementations, without contention and under short-hold contention, 
+// plus throughput and fairness (share of acquisitions per thread) as the number of contending threads grows
+// Usage: bench_locks [maximum threads count (default 4)]
+
+#include "thread_atomics.h"
+#include "thread_locks.h"
+#include "threads.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define UNCONTENDED_ITERATIONS_NUMBER 10000000
+#define CONTENDED_RUN_TIME_MS 300
+#define LATENCY_SAMPLE_INTERVAL 16
+#define MAX_LATENCY_SAMPLES_COUNT ( 1 << 20 )
+#define MAX_THREADS_COUNT 256
+
+typedef struct _BenchmarkThread
+{
+  Thread thread;
+  TLock lock;
+  volatile uint64_t* sharedCounter;
+  volatile uint32_t* startFlag;
+  volatile uint32_t* stopFlag;
+  uint64_t acquiresCount;
+  uint64_t* waitTimes;
+  size_t waitSamplesCount;
+}
+BenchmarkThread;
+
+static const enum TLockType LOCK_TYPES[] = { TLOCK_NATIVE, TLOCK_ADAPTIVE, TLOCK_TICKET, TLOCK_MCS };
+static const char* LOCK_NAMES[] = { "native", "adaptive", "ticket", "mcs" };
+#define LOCK_TYPES_COUNT ( sizeof(LOCK_TYPES) / sizeof(enum TLockType) )
+
+static int CompareTimes( const void* ref_time_1, const void* ref_time_2 )
+{
+  uint64_t time_1 = *((const uint64_t*) ref_time_1), time_2 = *((const uint64_t*) ref_time_2);
+  return ( time_1 > time_2 ) - ( time_1 < time_2 );
+}
+
+// Few dozen nanoseconds of work, inside or outside the critical section
+static inline void DoWork( volatile uint64_t* counter )
+{
+  for( size_t i = 0; i < 8; i++ ) (*counter)++;
+}
+
+// Acquires lock until stopped, counting acquisitions and sampling their latencies
+static void* RunContender( void* args )
+{
+  BenchmarkThread* contender = (BenchmarkThread*) args;
+  volatile uint64_t localCounter = 0;
+  
+  while( __atomic_load_n( contender->startFlag, __ATOMIC_ACQUIRE ) == 0 ) Atomic_Pause();
+  
+  while( __atomic_load_n( contender->stopFlag, __ATOMIC_RELAXED ) == 0 )
+  {
+    if( contender->acquiresCount % LATENCY_SAMPLE_INTERVAL == 0 && contender->waitSamplesCount < MAX_LATENCY_SAMPLES_COUNT )
+    {
+      uint64_t startTime = Atomic_GetTime();
+      TLock_Acquire( contender->lock );
+      contender->waitTimes[ contender->waitSamplesCount++ ] = Atomic_GetTime() - startTime;
+    }
+    else TLock_Acquire( contender->lock );
+    DoWork( contender->sharedCounter );
+    TLock_Release( contender->lock );
+    DoWork( &localCounter );
+    contender->acquiresCount++;
+  }
+  
+  return NULL;
+}
+
+// Runs given number of threads contending for a lock of given type, returning the elapsed time (in nanoseconds)
+static double RunContenders( enum TLockType type, BenchmarkThread* contenders, size_t threadsCount )
+{
+  TLock lock = TLock_CreateType( type );
+  volatile uint64_t sharedCounter = 0;
+  volatile uint32_t startFlag = 0, stopFlag = 0;
+  
+  for( size_t threadIndex = 0; threadIndex < threadsCount; threadIndex++ )
+  {
+    BenchmarkThread* contender = &(contenders[ threadIndex ]);
+    contender->lock = lock;
+    contender->sharedCounter = &sharedCounter;
+    contender->startFlag = &startFlag;
+    contender->stopFlag = &stopFlag;
+    contender->acquiresCount = 0;
+    contender->waitTimes = (uint64_t*) malloc( MAX_LATENCY_SAMPLES_COUNT * sizeof(uint64_t) );
+    contender->waitSamplesCount = 0;
+    contender->thread = Thread_Start( RunContender, (void*) contender, THREAD_JOINABLE );
+  }
+  
+  uint64_t startTime = Atomic_GetTime();
+  __atomic_store_n( &startFlag, 1, __ATOMIC_RELEASE );
+  struct timespec runTime = { .tv_sec = CONTENDED_RUN_TIME_MS / 1000, .tv_nsec = ( CONTENDED_RUN_TIME_MS % 1000 ) * 1000000L };
+  nanosleep( &runTime, NULL );
+  __atomic_store_n( &stopFlag, 1, __ATOMIC_RELAXED );
+  for( size_t threadIndex = 0; threadIndex < threadsCount; threadIndex++ )
+    Thread_WaitExit( contenders[ threadIndex ].thread, INFINITE );
+  double elapsedTime = (double) ( Atomic_GetTime() - startTime );
+  
+  TLock_Discard( lock );
+  
+  return elapsedTime;
+}
+
+static void MeasureUncontended( enum TLockType type, const char* name )
+{
+  TLock lock = TLock_CreateType( type );
+  
+  uint64_t startTime = Atomic_GetTime();
+  for( size_t iteration = 0; iteration < UNCONTENDED_ITERATIONS_NUMBER; iteration++ )
+  {
+    TLock_Acquire( lock );
+    TLock_Release( lock );
+  }
+  double elapsedTime = (double) ( Atomic_GetTime() - startTime );
+  
+  printf( "%-10s %14.1f\n", name, elapsedTime / UNCONTENDED_ITERATIONS_NUMBER );
+  
+  TLock_Discard( lock );
+}
+
+static void MeasureContended( enum TLockType type, const char* name, size_t threadsCount )
+{
+  BenchmarkThread* contenders = (BenchmarkThread*) calloc( threadsCount, sizeof(BenchmarkThread) );
+  double elapsedTime = RunContenders( type, contenders, threadsCount );
+  
+  // Merge latency samples of all threads for mean and percentiles
+  size_t waitTimesCount = 0;
+  for( size_t threadIndex = 0; threadIndex < threadsCount; threadIndex++ )
+    waitTimesCount += contenders[ threadIndex ].waitSamplesCount;
+  uint64_t* waitTimes = (uint64_t*) malloc( ( waitTimesCount + 1 ) * sizeof(uint64_t) );
+  double waitTimesSum = 0.0, acquiresSum = 0.0;
+  waitTimesCount = 0;
+  for( size_t threadIndex = 0; threadIndex < threadsCount; threadIndex++ )
+  {
+    for( size_t sampleIndex = 0; sampleIndex < contenders[ threadIndex ].waitSamplesCount; sampleIndex++ )
+    {
+      waitTimes[ waitTimesCount++ ] = contenders[ threadIndex ].waitTimes[ sampleIndex ];
+      waitTimesSum += (double) contenders[ threadIndex ].waitTimes[ sampleIndex ];
+    }
+    acquiresSum += (double) contenders[ threadIndex ].acquiresCount;
+    free( contenders[ threadIndex ].waitTimes );
+  }
+  qsort( waitTimes, waitTimesCount, sizeof(uint64_t), CompareTimes );
+  waitTimes[ waitTimesCount ] = 0;
+  
+  printf( "%-10s %8zu %12.2f %12.1f %12llu %12llu\n", name, threadsCount, acquiresSum / elapsedTime * 1e3, 
+          ( waitTimesCount > 0 ) ? waitTimesSum / waitTimesCount : 0.0, (unsigned long long) waitTimes[ waitTimesCount / 2 ], 
+          (unsigned long long) waitTimes[ waitTimesCount * 99 / 100 ] );
+  
+  free( waitTimes );
+  free( contenders );
+}
+
+// Fairness as Jain's index of per-thread acquisitions (1 when evenly shared, 1/n when a single thread gets them all)
+static void MeasureScaling( enum TLockType type, const char* name, size_t threadsCount )
+{
+  BenchmarkThread* contenders = (BenchmarkThread*) calloc( threadsCount, sizeof(BenchmarkThread) );
+  double elapsedTime = RunContenders( type, contenders, threadsCount );
+  
+  double acquiresSum = 0.0, acquiresSquaresSum = 0.0;
+  uint64_t minAcquiresCount = UINT64_MAX, maxAcquiresCount = 0;
+  for( size_t threadIndex = 0; threadIndex < threadsCount; threadIndex++ )
+  {
+    uint64_t acquiresCount = contenders[ threadIndex ].acquiresCount;
+    acquiresSum += (double) acquiresCount;
+    acquiresSquaresSum += (double) acquiresCount * (double) acquiresCount;
+    if( acquiresCount < minAcquiresCount ) minAcquiresCount = acquiresCount;
+    if( acquiresCount > maxAcquiresCount ) maxAcquiresCount = acquiresCount;
+    free( contenders[ threadIndex ].waitTimes );
+  }
+  double fairnessIndex = ( acquiresSquaresSum > 0.0 ) ? acquiresSum * acquiresSum / ( threadsCount * acquiresSquaresSum ) : 0.0;
+  
+  printf( "%-10s %8zu %12.2f %12.3f %12llu %12llu\n", name, threadsCount, acquiresSum / elapsedTime * 1e3, fairnessIndex,
+          (unsigned long long) minAcquiresCount, (unsigned long long) maxAcquiresCount );
+  
+  free( contenders );
+}
+
+int main( int argc, char* argv[] )
+{
+  size_t threadsCount = ( argc > 1 ) ? (size_t) strtoul( argv[ 1 ], NULL, 10 ) : 4;
+  if( threadsCount == 0 || threadsCount > MAX_THREADS_COUNT ) threadsCount = 4;
+  
+  printf( "uncontended acquire/release pair\n%-10s %14s\n", "lock", "latency (ns)" );
+  for( size_t typeIndex = 0; typeIndex < LOCK_TYPES_COUNT; typeIndex++ )
+    MeasureUncontended( LOCK_TYPES[ typeIndex ], LOCK_NAMES[ typeIndex ] );
+  
+  printf( "\nshort-hold contention over %d ms (acquisition latency sampled every %d operations)\n", CONTENDED_RUN_TIME_MS, LATENCY_SAMPLE_INTERVAL );
+  printf( "%-10s %8s %12s %12s %12s %12s\n", "lock", "threads", "Mops/s", "mean (ns)", "median (ns)", "p99 (ns)" );
+  for( size_t typeIndex = 0; typeIndex < LOCK_TYPES_COUNT; typeIndex++ )
+    MeasureContended( LOCK_TYPES[ typeIndex ], LOCK_NAMES[ typeIndex ], threadsCount );
+  
+  printf( "\nthroughput and fairness as threads grow\n" );
+  printf( "%-10s %8s %12s %12s %12s %12s\n", "lock", "threads", "Mops/s", "fairness", "min acquires", "max acquires" );
+  for( size_t typeIndex = 0; typeIndex < LOCK_TYPES_COUNT; typeIndex++ )
+  {
+    // Powers of 2 up to the maximum count (always included)
+    size_t scalingThreadsCount = 1;
+    while( true )
+    {
+      MeasureScaling( LOCK_TYPES[ typeIndex ], LOCK_NAMES[ typeIndex ], scalingThreadsCount );
+      if( scalingThreadsCount == threadsCount ) break;
+      scalingThreadsCount = ( 2 * scalingThreadsCount < threadsCount ) ? 2 * scalingThreadsCount : threadsCount;
+    }
+  }
+  
+  return 0;
+}
@@ -0,0 +1,126 @@
+//////////////////////////////////////////////////////////////////////////////////////
+//                                                                                  //
+//  Copyright (c) 2016-2025 Leonardo Consoni <leonardojc@protonmail.com>            //
+//                                                                                  //
+//  This file is part of Simple Multithreading.                                     //
+//                                                                                  //
+//  Simple Multithreading is free software: you can redistribute it and/or modify   //
+//  it under the terms of the GNU Lesser General Public License as published        //
+//  by the Free Software Foundation, either version 3 of the License, or            //
+//  (at your option) any later version.                                             //
+//                                                                                  //
+//  Simple Multithreading is distributed in the hope that it will be useful,        //
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of                  //
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                    //
+//  GNU Lesser General Public License for more details.                             //
+//                                                                                  //
+//  You should have received a copy of the GNU Lesser General Public License        //
+//  along with Simple Multithreading. If not, see <http://www.gnu.org/licenses/>.   //
+//                                                                                  //
+//////////////////////////////////////////////////////////////////////////////////////
+
+// Scaling of embarrassingly parallel loops with the number of participating threads
+// (limited by splitting the range in as many static chunks), relative to a single thread
+
+#include "thread_atomics.h"
+#include "task_schedulers.h"
+#include "parallel_loops.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#define RANGE_LENGTH 2000000
+#define INNER_ITERATIONS_NUMBER 64
+#define REPETITIONS_NUMBER 5
+
+static double* values;
+
+// Compute bound work per index, without shared writes
+static double ComputeValue( size_t index )
+{
+  double value = (double) index;
+  for( size_t i = 0; i < INNER_ITERATIONS_NUMBER; i++ )
+    value = sqrt( value + 1.0 ) * 1.0001;
+  return value;
+}
+
+static void ComputeRange( size_t begin, size_t end, void* context )
+{
+  (void) context;
+  for( size_t index = begin; index < end; index++ )
+    values[ index ] = ComputeValue( index );
+}
+
+static void SumRange( size_t begin, size_t end, void* context, void* accumulator )
+{
+  (void) context;
+  double sum = 0.0;
+  for( size_t index = begin; index < end; index++ )
+    sum += ComputeValue( index );
+  *((double*) accumulator) += sum;
+}
+
+static void JoinSums( void* accumulator, const void* partial, void* context )
+{
+  (void) context;
+  *((double*) accumulator) += *((const double*) partial);
+}
+
+// Best time (in seconds) of a loop run with given number of threads
+static double MeasureLoop( size_t threadsCount, enum ParallelSchedule schedule, bool isReduction )
+{
+  // Static schedule takes a single block per thread, so chunk count bounds participants
+  size_t grain = ( RANGE_LENGTH + threadsCount - 1 ) / threadsCount;
+  if( schedule != PARALLEL_STATIC ) grain = 1024;
+  
+  double bestTime = HUGE_VAL;
+  for( size_t repetition = 0; repetition < REPETITIONS_NUMBER; repetition++ )
+  {
+    uint64_t startTime = Atomic_GetTime();
+    if( isReduction )
+    {
+      double sum = 0.0;
+      Parallel_Reduce( 0, RANGE_LENGTH, grain, schedule, SumRange, JoinSums, NULL, &sum, sizeof(double) );
+      if( sum <= 0.0 ) fprintf( stderr, "unexpected sum %g\n", sum );
+    }
+    else
+    {
+      Parallel_For( 0, RANGE_LENGTH, grain, schedule, ComputeRange, NULL );
+    }
+    double elapsedTime = (double) ( Atomic_GetTime() - startTime ) / 1e9;
+    if( elapsedTime < bestTime ) bestTime = elapsedTime;
+  }
+  
+  return bestTime;
+}
+
+int main()
+{
+  values = (double*) malloc( RANGE_LENGTH * sizeof(double) );
+  
+  size_t maxThreadsCount = TaskScheduler_GetWorkersCount( TaskScheduler_GetDefault() ) + 1;
+  const char* labels[] = { "for static", "for dynamic", "for guided", "reduce static" };
+  enum ParallelSchedule schedules[] = { PARALLEL_STATIC, PARALLEL_DYNAMIC, PARALLEL_GUIDED, PARALLEL_STATIC };
+  
+  printf( "%-14s %8s %10s %8s %10s\n", "loop", "threads", "time (ms)", "speedup", "efficiency" );
+  for( size_t loopIndex = 0; loopIndex < 4; loopIndex++ )
+  {
+    bool isReduction = ( loopIndex == 3 );
+    double baseTime = MeasureLoop( 1, PARALLEL_STATIC, isReduction );
+    // Dynamic schedules always use every thread, so they are only compared at full width
+    size_t threadsCount = ( schedules[ loopIndex ] == PARALLEL_STATIC ) ? 1 : maxThreadsCount;
+    while( threadsCount <= maxThreadsCount )
+    {
+      double loopTime = MeasureLoop( threadsCount, schedules[ loopIndex ], isReduction );
+      printf( "%-14s %8zu %10.2f %8.2f %9.0f%%\n", labels[ loopIndex ], threadsCount, loopTime * 1e3, 
+              baseTime / loopTime, 100.0 * baseTime / loopTime / threadsCount );
+      if( threadsCount == maxThreadsCount ) break;
+      threadsCount = ( 2 * threadsCount < maxThreadsCount ) ? 2 * threadsCount : maxThreadsCount;
+    }
+  }
+  
+  free( values );
+  
+  return 0;
+}
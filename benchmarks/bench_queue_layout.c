@@ -0,0 +1,265 @@
+//////////////////////////////////////////////////////////////////////////////////////
+//                                                                                  //
+//  Copyright (c) 2016-2025 Leonardo Consoni <leonardojc@protonmail.com>            //
+//                                                                                  //
+//  This file is part of Simple Multithreading.                                     //
+//                                                                                  //
+//  Simple Multithreading is free software: you can redistribute it and/or modify   //
+//  it under the terms of the GNU Lesser General Public License as published        //
+//  by the Free Software Foundation, either version 3 of the License, or            //
+//  (at your option) any later version.                                             //
+//                                                                                  //
+//  Simple Multithreading is distributed in the hope that it will be useful,        //
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of                  //
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                    //
+//  GNU Lesser General Public License for more details.                             //
+//                                                                                  //
+//  You should have received a copy of the GNU Lesser General Public License        //
+//  along with Simple Multithreading. If not, see <http://www.gnu.org/licenses/>.   //
+//                                                                                  //
+//////////////////////////////////////////////////////////////////////////////////////
+
+// Cost of queue slot storage layouts: the previous table of separately allocated slots, indexed by modulo (allocated 
+// in a row, or scattered over a fragmented heap), against the single slab of cache line aligned slots indexed by mask 
+// now used by TSQueue. Rings are swept by a single thread filling and then draining them, as a backlog would, and 
+// by a producer and a consumer thread handing items over through slot sequence numbers, as lock-free queues do
+// Usage: bench_queue_layout [items per single thread measurement (default 16M, a quarter of it for handoffs)]
+
+#include "thread_atomics.h"
+#include "threads.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#define DEFAULT_ITEMS_NUMBER ( 16 * 1024 * 1024 )
+#define REPETITIONS_NUMBER 3
+#define WAIT_SPIN_COUNT 1000
+
+// Same slot header as the queue: a sequence number before the item data
+typedef struct _Slot
+{
+  volatile size_t sequence;
+  uint8_t data[];
+}
+Slot;
+
+typedef struct _Ring
+{
+  Slot** table;         // Previous layout
+  uint8_t* slab;        // Current layout
+  size_t length, mask, stride;
+  size_t itemSize, itemsNumber;
+}
+Ring;
+
+static const size_t QUEUE_LENGTHS[] = { 1024, 65536, 262144 };
+static const size_t ITEM_SIZES[] = { 8, 64 };
+#define QUEUE_LENGTHS_COUNT ( sizeof(QUEUE_LENGTHS) / sizeof(size_t) )
+#define ITEM_SIZES_COUNT ( sizeof(ITEM_SIZES) / sizeof(size_t) )
+
+// Keeps the reads from being optimized away
+static volatile size_t checksumSink;
+
+enum { LAYOUT_TABLE, LAYOUT_SCATTERED_TABLE, LAYOUT_SLAB, LAYOUTS_COUNT };
+static const char* LAYOUT_NAMES[ LAYOUTS_COUNT ] = { "table", "scattered", "slab" };
+
+static bool CreateRing( Ring* ring, int layout, size_t length, size_t itemSize )
+{
+  *ring = (Ring) { .table = NULL, .slab = NULL, .length = length, .itemSize = itemSize };
+  if( layout == LAYOUT_SLAB )
+  {
+    size_t capacity = 1;
+    while( capacity < length ) capacity <<= 1;
+    ring->mask = capacity - 1;
+    ring->stride = ( sizeof(Slot) + itemSize + ATOMIC_CACHE_LINE_SIZE - 1 ) & ~( (size_t) ATOMIC_CACHE_LINE_SIZE - 1 );
+    void* slab = NULL;
+    if( posix_memalign( &slab, ATOMIC_CACHE_LINE_SIZE, capacity * ring->stride ) != 0 ) return false;
+    ring->slab = (uint8_t*) slab;
+    for( size_t i = 0; i < capacity; i++ )
+      ( (Slot*) ( ring->slab + i * ring->stride ) )->sequence = i;
+    return true;
+  }
+  
+  ring->table = (Slot**) calloc( length, sizeof(Slot*) );
+  if( ring->table == NULL ) return false;
+  // Long lived process heaps interleave queue slots with other allocations of varied sizes
+  void** fillersList = ( layout == LAYOUT_SCATTERED_TABLE ) ? (void**) calloc( length, sizeof(void*) ) : NULL;
+  for( size_t i = 0; i < length; i++ )
+  {
+    ring->table[ i ] = (Slot*) malloc( sizeof(Slot) + itemSize );
+    ring->table[ i ]->sequence = i;
+    if( fillersList != NULL ) fillersList[ i ] = malloc( 16 + ( rand() % 16 ) * 32 );
+  }
+  if( fillersList != NULL )
+  {
+    for( size_t i = 0; i < length; i++ )
+      free( fillersList[ i ] );
+    free( fillersList );
+  }
+  
+  return true;
+}
+
+static void DiscardRing( Ring* ring )
+{
+  if( ring->table != NULL )
+  {
+    for( size_t i = 0; i < ring->length; i++ )
+      free( ring->table[ i ] );
+    free( ring->table );
+  }
+  free( ring->slab );
+}
+
+static inline Slot* GetSlot( Ring* ring, size_t position )
+{
+  if( ring->table != NULL ) return ring->table[ position % ring->length ];
+  return (Slot*) ( ring->slab + ( position & ring->mask ) * ring->stride );
+}
+
+// Returns nanoseconds per item written and read back
+static double MeasureSweeps( Ring* ring, size_t itemsNumber )
+{
+  size_t itemSize = ring->itemSize;
+  uint8_t item[ 64 ] = { 0 };
+  size_t passesNumber = ( itemsNumber + ring->length - 1 ) / ring->length;
+  size_t first = 0, last = 0, checksum = 0;
+  
+  uint64_t startTime = Atomic_GetTime();
+  for( size_t pass = 0; pass < passesNumber; pass++ )
+  {
+    for( size_t i = 0; i < ring->length; i++ )
+    {
+      Slot* slot = GetSlot( ring, last );
+      item[ 0 ] = (uint8_t) last;
+      memcpy( slot->data, item, itemSize );
+      slot->sequence = ++last;
+    }
+    for( size_t i = 0; i < ring->length; i++ )
+    {
+      Slot* slot = GetSlot( ring, first );
+      memcpy( item, slot->data, itemSize );
+      checksum += item[ 0 ] + ( slot->sequence == first + 1 );
+      first++;
+    }
+  }
+  double elapsedTime = (double) ( Atomic_GetTime() - startTime );
+  
+  checksumSink = checksum;
+  
+  return elapsedTime / ( passesNumber * ring->length );
+}
+
+// Waits for given slot to get the expected sequence number, giving the processor away if it takes long
+static inline void WaitSequence( Slot* slot, size_t sequence )
+{
+  size_t spinsCount = 0;
+  while( __atomic_load_n( &(slot->sequence), __ATOMIC_ACQUIRE ) != sequence )
+  {
+    if( ++spinsCount < WAIT_SPIN_COUNT ) Atomic_Pause();
+    else Atomic_Yield();
+  }
+}
+
+static void* RunProducer( void* args )
+{
+  Ring* ring = (Ring*) args;
+  uint8_t item[ 64 ] = { 0 };
+  
+  for( size_t position = 0; position < ring->itemsNumber; position++ )
+  {
+    Slot* slot = GetSlot( ring, position );
+    WaitSequence( slot, position );
+    item[ 0 ] = (uint8_t) position;
+    memcpy( slot->data, item, ring->itemSize );
+    __atomic_store_n( &(slot->sequence), position + 1, __ATOMIC_RELEASE );
+  }
+  
+  return NULL;
+}
+
+// Returns nanoseconds per item passed from producer to consumer
+static double MeasureHandoff( Ring* ring, size_t itemsNumber )
+{
+  uint8_t item[ 64 ] = { 0 };
+  size_t capacity = ( ring->table != NULL ) ? ring->length : ring->mask + 1;
+  size_t checksum = 0;
+  
+  // Rings start from position 0 again, so sequence numbers are reset
+  for( size_t i = 0; i < capacity; i++ )
+    GetSlot( ring, i )->sequence = i;
+  ring->itemsNumber = itemsNumber;
+  
+  uint64_t startTime = Atomic_GetTime();
+  Thread producer = Thread_Start( RunProducer, (void*) ring, THREAD_JOINABLE );
+  for( size_t position = 0; position < itemsNumber; position++ )
+  {
+    Slot* slot = GetSlot( ring, position );
+    WaitSequence( slot, position + 1 );
+    memcpy( item, slot->data, ring->itemSize );
+    checksum += item[ 0 ];
+    __atomic_store_n( &(slot->sequence), position + capacity, __ATOMIC_RELEASE );
+  }
+  Thread_WaitExit( producer, INFINITE );
+  double elapsedTime = (double) ( Atomic_GetTime() - startTime );
+  
+  checksumSink = checksum;
+  
+  return elapsedTime / itemsNumber;
+}
+
+typedef double (*MeasureFunction)( Ring*, size_t );
+
+// Prints the best time per item of given measurement for each layout, item size and queue length
+static bool CompareLayouts( const char* title, MeasureFunction Measure, size_t itemsNumber )
+{
+  printf( "%s, best of %d runs (ns per item)\n%8s %10s", title, REPETITIONS_NUMBER, "item", "length" );
+  for( int layout = 0; layout < LAYOUTS_COUNT; layout++ )
+    printf( " %12s", LAYOUT_NAMES[ layout ] );
+  printf( " %12s\n", "slab speedup" );
+  
+  for( size_t sizeIndex = 0; sizeIndex < ITEM_SIZES_COUNT; sizeIndex++ )
+  {
+    for( size_t lengthIndex = 0; lengthIndex < QUEUE_LENGTHS_COUNT; lengthIndex++ )
+    {
+      size_t itemSize = ITEM_SIZES[ sizeIndex ], length = QUEUE_LENGTHS[ lengthIndex ];
+      double itemTimes[ LAYOUTS_COUNT ];
+      printf( "%8zu %10zu", itemSize, length );
+      for( int layout = 0; layout < LAYOUTS_COUNT; layout++ )
+      {
+        Ring ring;
+        if( !CreateRing( &ring, layout, length, itemSize ) ) 
+        {
+          fprintf( stderr, "\nallocation failed\n" );
+          return false;
+        }
+        itemTimes[ layout ] = Measure( &ring, itemsNumber );
+        for( int repetition = 1; repetition < REPETITIONS_NUMBER; repetition++ )
+        {
+          double itemTime = Measure( &ring, itemsNumber );
+          if( itemTime < itemTimes[ layout ] ) itemTimes[ layout ] = itemTime;
+        }
+        DiscardRing( &ring );
+        printf( " %12.2f", itemTimes[ layout ] );
+      }
+      printf( " %11.2fx\n", itemTimes[ LAYOUT_TABLE ] / itemTimes[ LAYOUT_SLAB ] );
+      fflush( stdout );
+    }
+  }
+  
+  return true;
+}
+
+int main( int argc, char* argv[] )
+{
+  size_t itemsNumber = ( argc > 1 ) ? (size_t) strtoul( argv[ 1 ], NULL, 10 ) : DEFAULT_ITEMS_NUMBER;
+  if( itemsNumber == 0 ) itemsNumber = DEFAULT_ITEMS_NUMBER;
+  
+  if( !CompareLayouts( "single thread ring fill and drain", MeasureSweeps, itemsNumber ) ) return -1;
+  printf( "\n" );
+  if( !CompareLayouts( "producer to consumer thread handoff", MeasureHandoff, ( itemsNumber + 3 ) / 4 ) ) return -1;
+  
+  return 0;
+}
@@ -0,0 +1,138 @@
+//////////////////////////////////////////////////////////////////////////////////////
+//                                                                                  //
+//  Copyright (c) 2016-2025 Leonardo Consoni <leonardojc@protonmail.com>            //
+//                                                                                  //
+//  This file is part of Simple Multithreading.                                     //
+//                                                                                  //
+//  Simple Multithreading is free software: you can redistribute it and/or modify   //
+//  it under the terms of the GNU Lesser General Public License as published        //
+//  by the Free Software Foundation, either version 3 of the License, or            //
+//  (at your option) any later version.                                             //
+//                                                                                  //
+//  Simple Multithreading is distributed in the hope that it will be useful,        //
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of                  //
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                    //
+//  GNU Lesser General Public License for more details.                             //
+//                                                                                  //
+//  You should have received a copy of the GNU Lesser General Public License        //
+//  along with Simple Multithreading. If not, see <http://www.gnu.org/licenses/>.   //
+//                                                                                  //
+//////////////////////////////////////////////////////////////////////////////////////
+
+// Throughput of the lock-free multiple producer/consumer queue against the lock and semaphores based one, 
+// with equal numbers of producer and consumer threads growing from 1 up to 32
+// Usage: bench_queues [maximum producers/consumers count (default 32)]
+
+#include "thread_atomics.h"
+#include "thread_safe_queues.h"
+#include "threads.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define ITEMS_NUMBER ( 1 << 20 )
+#define QUEUE_LENGTH 1024
+#define MAX_THREADS_COUNT 32
+
+typedef struct _BenchmarkThread
+{
+  Thread thread;
+  TSQueue queue;
+  size_t itemsCount;
+  volatile uint32_t* startFlag;
+}
+BenchmarkThread;
+
+static const enum TSQueueType QUEUE_TYPES[] = { TSQUEUE_LOCKED, TSQUEUE_MPMC };
+static const char* QUEUE_NAMES[] = { "locked", "mpmc" };
+#define QUEUE_TYPES_COUNT ( sizeof(QUEUE_TYPES) / sizeof(enum TSQueueType) )
+
+static void* RunProducer( void* args )
+{
+  BenchmarkThread* producer = (BenchmarkThread*) args;
+  
+  while( __atomic_load_n( producer->startFlag, __ATOMIC_ACQUIRE ) == 0 ) Atomic_Yield();
+  
+  for( size_t itemIndex = 0; itemIndex < producer->itemsCount; itemIndex++ )
+  {
+    uint64_t item = itemIndex;
+    TSQ_Enqueue( producer->queue, &item, TSQUEUE_WAIT );
+  }
+  
+  return NULL;
+}
+
+static void* RunConsumer( void* args )
+{
+  BenchmarkThread* consumer = (BenchmarkThread*) args;
+  
+  while( __atomic_load_n( consumer->startFlag, __ATOMIC_ACQUIRE ) == 0 ) Atomic_Yield();
+  
+  for( size_t itemIndex = 0; itemIndex < consumer->itemsCount; itemIndex++ )
+  {
+    uint64_t item;
+    TSQ_Dequeue( consumer->queue, &item, TSQUEUE_WAIT );
+  }
+  
+  return NULL;
+}
+
+// Every producer inserts as many items as each consumer removes, so all threads finish once the queue is drained
+static double MeasureThroughput( enum TSQueueType type, size_t threadsCount )
+{
+  TSQueue queue = TSQ_CreateType( QUEUE_LENGTH, sizeof(uint64_t), type );
+  BenchmarkThread producers[ MAX_THREADS_COUNT ], consumers[ MAX_THREADS_COUNT ];
+  volatile uint32_t startFlag = 0;
+  
+  for( size_t threadIndex = 0; threadIndex < threadsCount; threadIndex++ )
+  {
+    producers[ threadIndex ] = (BenchmarkThread) { .queue = queue, .itemsCount = ITEMS_NUMBER / threadsCount, .startFlag = &startFlag };
+    consumers[ threadIndex ] = producers[ threadIndex ];
+    producers[ threadIndex ].thread = Thread_Start( RunProducer, &(producers[ threadIndex ]), THREAD_JOINABLE );
+    consumers[ threadIndex ].thread = Thread_Start( RunConsumer, &(consumers[ threadIndex ]), THREAD_JOINABLE );
+  }
+  
+  uint64_t startTime = Atomic_GetTime();
+  __atomic_store_n( &startFlag, 1, __ATOMIC_RELEASE );
+  for( size_t threadIndex = 0; threadIndex < threadsCount; threadIndex++ )
+  {
+    Thread_WaitExit( producers[ threadIndex ].thread, INFINITE );
+    Thread_WaitExit( consumers[ threadIndex ].thread, INFINITE );
+  }
+  double elapsedTime = (double) ( Atomic_GetTime() - startTime );
+  
+  TSQ_Discard( queue );
+  
+  return (double) ( ITEMS_NUMBER / threadsCount * threadsCount ) / elapsedTime * 1e3;
+}
+
+int main( int argc, char* argv[] )
+{
+  size_t maxThreadsCount = ( argc > 1 ) ? (size_t) strtoul( argv[ 1 ], NULL, 10 ) : MAX_THREADS_COUNT;
+  if( maxThreadsCount == 0 || maxThreadsCount > MAX_THREADS_COUNT ) maxThreadsCount = MAX_THREADS_COUNT;
+  
+  printf( "%zu items of %zu bytes through a %d items queue (Mitems/s)\n", (size_t) ITEMS_NUMBER, sizeof(uint64_t), QUEUE_LENGTH );
+  printf( "%-19s", "producers/consumers" );
+  for( size_t typeIndex = 0; typeIndex < QUEUE_TYPES_COUNT; typeIndex++ )
+    printf( " %12s", QUEUE_NAMES[ typeIndex ] );
+  printf( " %12s\n", "mpmc speedup" );
+  
+  // Powers of 2 up to the maximum count (always included)
+  size_t threadsCount = 1;
+  while( true )
+  {
+    double throughputs[ QUEUE_TYPES_COUNT ];
+    printf( "%-19zu", threadsCount );
+    for( size_t typeIndex = 0; typeIndex < QUEUE_TYPES_COUNT; typeIndex++ )
+    {
+      throughputs[ typeIndex ] = MeasureThroughput( QUEUE_TYPES[ typeIndex ], threadsCount );
+      printf( " %12.2f", throughputs[ typeIndex ] );
+    }
+    printf( " %11.2fx\n", throughputs[ 1 ] / throughputs[ 0 ] );
+    fflush( stdout );
+    if( threadsCount == maxThreadsCount ) break;
+    threadsCount = ( 2 * threadsCount < maxThreadsCount ) ? 2 * threadsCount : maxThreadsCount;
+  }
+  
+  return 0;
+}
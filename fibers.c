@@ -0,0 +1,542 @@
+//////////////////////////////////////////////////////////////////////////////////////
+//                                                                                  //
+//  Copyright (c) 2016-2025 Leonardo Consoni <leonardojc@protonmail.com>            //
+//                                                                                  //
+//  This file is part of Simple Multithreading.                                     //
+//                                                                                  //
+//  Simple Multithreading is free software: you can redistribute it and/or modify   //
+//  it under the terms of the GNU Lesser General Public License as published        //
+//  by the Free Software Foundation, either version 3 of the License, or            //
+//  (at your option) any later version.                                             //
+//                                                                                  //
+//  Simple Multithreading is distributed in the hope that it will be useful,        //
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of                  //
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                    //
+//  GNU Lesser General Public License for more details.                             //
+//                                                                                  //
+//  You should have received a copy of the GNU Lesser General Public License        //
+//  along with Simple Multithreading. If not, see <http://www.gnu.org/licenses/>.   //
+//                                                                                  //
+//////////////////////////////////////////////////////////////////////////////////////
+
+#include "thread_atomics.h"
+
+#include "fibers.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+static const size_t DEFAULT_STACK_SIZE = 64 * 1024;
+static const size_t RUN_QUEUE_LENGTH_INCREMENT = 64;
+static const uint32_t SPIN_LOCK_PAUSE_COUNT = 64;
+#define PARKING_BUCKETS_COUNT 64
+
+typedef struct _FiberData FiberData;
+typedef FiberData* Fiber;
+typedef struct _Carrier Carrier;
+
+static void RunFiber( void );
+
+
+#ifdef WIN32
+
+#include <Windows.h>
+
+typedef LPVOID FiberContext;
+
+static void WINAPI RunFiberNative( LPVOID args ) { RunFiber(); }
+
+#else // Unix
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#if defined( __x86_64__ ) && defined( __ELF__ )
+
+typedef void* FiberContext;     // Saved stack pointer, with callee-saved registers pushed on top
+
+// Saves callee-saved registers (and floating point control words) on current stack and restores them from the other
+__asm__(
+  ".text\n"
+  ".p2align 4\n"
+  ".globl Fibers_SwitchStack\n"
+  ".hidden Fibers_SwitchStack\n"
+  ".type Fibers_SwitchStack, @function\n"
+  "Fibers_SwitchStack:\n"
+  "  pushq %rbp\n"
+  "  pushq %rbx\n"
+  "  pushq %r12\n"
+  "  pushq %r13\n"
+  "  pushq %r14\n"
+  "  pushq %r15\n"
+  "  subq $8, %rsp\n"
+  "  stmxcsr (%rsp)\n"
+  "  fnstcw 4(%rsp)\n"
+  "  movq %rsp, (%rdi)\n"
+  "  movq %rsi, %rsp\n"
+  "  ldmxcsr (%rsp)\n"
+  "  fldcw 4(%rsp)\n"
+  "  addq $8, %rsp\n"
+  "  popq %r15\n"
+  "  popq %r14\n"
+  "  popq %r13\n"
+  "  popq %r12\n"
+  "  popq %rbx\n"
+  "  popq %rbp\n"
+  "  ret\n"
+  ".size Fibers_SwitchStack, .-Fibers_SwitchStack\n"
+);
+void Fibers_SwitchStack( void** fromStack, void* toStack );
+
+#else
+
+#include <ucontext.h>
+
+typedef ucontext_t FiberContext;
+
+#endif
+
+#endif // WIN32
+
+
+struct _FiberData
+{
+  FiberContext context;
+  void* stack;
+  size_t stackSize;
+  AsyncFunction function;
+  void* args;
+  Carrier* carrier;
+  bool isFinished, isBlocked;
+  volatile uint32_t* parkAddress;
+  struct _FiberData* nextParked;
+};
+
+struct _Carrier
+{
+  FiberContext context;
+  FiberScheduler scheduler;
+  Thread thread;
+  volatile uint32_t queueLock;
+  Fiber* runQueue;
+  size_t queueFirst, queueCount, queueLength;
+  volatile uint32_t wakeEpoch;
+  volatile bool isSleeping;
+};
+
+struct _FiberSchedulerData
+{
+  Carrier* carriers;
+  size_t carriersCount;
+  size_t stackSize;
+  volatile size_t nextCarrier;
+  volatile size_t activeFibersCount;
+  volatile bool isRunning;
+};
+
+// Fibers suspended on memory words hashing to the same bucket (futex emulation for fiber-aware blocking)
+typedef struct _ParkingBucket
+{
+  volatile uint32_t lock;
+  volatile uint32_t waitersCount;
+  Fiber waitersList;
+  uint8_t padding[ ATOMIC_CACHE_LINE_SIZE - 2 * sizeof(uint32_t) - sizeof(Fiber) ];
+}
+ParkingBucket;
+
+static THREAD_LOCAL Fiber currentFiber = NULL;
+
+static ParkingBucket parkingLot[ PARKING_BUCKETS_COUNT ];
+
+
+#ifdef WIN32
+
+static bool InitCarrierContext( Carrier* carrier )
+{
+  carrier->context = ConvertThreadToFiber( NULL );
+  return ( carrier->context != NULL );
+}
+
+static void EndCarrierContext( Carrier* carrier ) { ConvertFiberToThread(); }
+
+static bool CreateContext( Fiber fiber )
+{
+  fiber->stack = NULL;
+  fiber->context = CreateFiber( fiber->stackSize, RunFiberNative, NULL );
+  return ( fiber->context != NULL );
+}
+
+static void DiscardContext( Fiber fiber ) { DeleteFiber( fiber->context ); }
+
+static inline void SwitchContext( FiberContext* fromContext, FiberContext* toContext ) { SwitchToFiber( *toContext ); }
+
+#else // Unix
+
+static bool InitCarrierContext( Carrier* carrier ) { (void) carrier; return true; }
+
+static void EndCarrierContext( Carrier* carrier ) { (void) carrier; }
+
+// Fiber stacks are mapped with an inaccessible guard page below them, so that overflows fault
+static bool CreateContext( Fiber fiber )
+{
+  size_t pageSize = (size_t) sysconf( _SC_PAGESIZE );
+  fiber->stackSize = ( fiber->stackSize + pageSize - 1 ) / pageSize * pageSize;
+  fiber->stack = mmap( NULL, fiber->stackSize + pageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0 );
+  if( fiber->stack == MAP_FAILED ) return false;
+  mprotect( fiber->stack, pageSize, PROT_NONE );
+  uint8_t* stackBase = (uint8_t*) fiber->stack + pageSize;
+  
+#if defined( __x86_64__ ) && defined( __ELF__ )
+  // Initial frame popped by the first switch: control words, zeroed registers and RunFiber() as return address
+  uint64_t* stackTop = (uint64_t*) ( (uintptr_t) ( stackBase + fiber->stackSize ) & ~( (uintptr_t) 15 ) );
+  *(--stackTop) = 0;
+  *(--stackTop) = (uint64_t) (uintptr_t) RunFiber;
+  for( size_t i = 0; i < 6; i++ ) *(--stackTop) = 0;
+  *(--stackTop) = (uint64_t) 0x1F80 | ( (uint64_t) 0x037F << 32 );
+  fiber->context = (FiberContext) stackTop;
+#else
+  getcontext( &(fiber->context) );
+  fiber->context.uc_stack.ss_sp = stackBase;
+  fiber->context.uc_stack.ss_size = fiber->stackSize;
+  fiber->context.uc_link = NULL;
+  makecontext( &(fiber->context), RunFiber, 0 );
+#endif
+  
+  return true;
+}
+
+static void DiscardContext( Fiber fiber )
+{
+  munmap( fiber->stack, fiber->stackSize + (size_t) sysconf( _SC_PAGESIZE ) );
+}
+
+static inline void SwitchContext( FiberContext* fromContext, FiberContext* toContext )
+{
+#if defined( __x86_64__ ) && defined( __ELF__ )
+  Fibers_SwitchStack( fromContext, *toContext );
+#else
+  swapcontext( fromContext, toContext );
+#endif
+}
+
+#endif // WIN32
+
+
+// Fiber entry point (never returns: finished fibers switch back to their carrier for disposal)
+static void RunFiber( void )
+{
+  Fiber fiber = currentFiber;
+  
+  fiber->function( fiber->args );
+  
+  fiber->isFinished = true;
+  SwitchContext( &(fiber->context), &(fiber->carrier->context) );
+}
+
+// Switches from calling fiber back to its carrier
+static void SuspendFiber( bool isBlocked )
+{
+  Fiber fiber = currentFiber;
+  
+  fiber->isBlocked = isBlocked;
+  SwitchContext( &(fiber->context), &(fiber->carrier->context) );
+}
+
+// Runtime internal locks never suspend fibers, as they are taken on the resuming path itself
+static void AcquireSpinLock( volatile uint32_t* lock )
+{
+  uint32_t pausesCount = 0;
+  while( __atomic_exchange_n( lock, 1, __ATOMIC_ACQUIRE ) != 0 )
+  {
+    while( __atomic_load_n( lock, __ATOMIC_RELAXED ) != 0 )
+    {
+      if( ++pausesCount % SPIN_LOCK_PAUSE_COUNT == 0 ) Atomic_Yield();
+      else Atomic_Pause();
+    }
+  }
+}
+
+static inline void ReleaseSpinLock( volatile uint32_t* lock ) { __atomic_store_n( lock, 0, __ATOMIC_RELEASE ); }
+
+// Appends fiber to carrier run queue
+static void PushFiber( Carrier* carrier, Fiber fiber )
+{
+  AcquireSpinLock( &(carrier->queueLock) );
+  if( carrier->queueCount == carrier->queueLength )
+  {
+    size_t newLength = carrier->queueLength + RUN_QUEUE_LENGTH_INCREMENT;
+    Fiber* newQueue = (Fiber*) malloc( newLength * sizeof(Fiber) );
+    for( size_t i = 0; i < carrier->queueCount; i++ )
+      newQueue[ i ] = carrier->runQueue[ ( carrier->queueFirst + i ) % carrier->queueLength ];
+    free( carrier->runQueue );
+    carrier->runQueue = newQueue;
+    carrier->queueLength = newLength;
+    carrier->queueFirst = 0;
+  }
+  carrier->runQueue[ ( carrier->queueFirst + carrier->queueCount ) % carrier->queueLength ] = fiber;
+  carrier->queueCount++;
+  ReleaseSpinLock( &(carrier->queueLock) );
+}
+
+static Fiber PopFiber( Carrier* carrier )
+{
+  Fiber fiber = NULL;
+  
+  AcquireSpinLock( &(carrier->queueLock) );
+  if( carrier->queueCount > 0 )
+  {
+    fiber = carrier->runQueue[ carrier->queueFirst ];
+    carrier->queueFirst = ( carrier->queueFirst + 1 ) % carrier->queueLength;
+    carrier->queueCount--;
+  }
+  ReleaseSpinLock( &(carrier->queueLock) );
+  
+  return fiber;
+}
+
+// Awakes carrier thread if it is sleeping (costs only an atomic increment otherwise)
+static void WakeCarrier( Carrier* carrier )
+{
+  __atomic_fetch_add( &(carrier->wakeEpoch), 1, __ATOMIC_SEQ_CST );
+  if( __atomic_load_n( &(carrier->isSleeping), __ATOMIC_SEQ_CST ) ) Atomic_WakeThreads( &(carrier->wakeEpoch), false );
+}
+
+// Blocks carrier thread until woken after given epoch
+static void WaitCarrier( Carrier* carrier, uint32_t epoch )
+{
+  __atomic_store_n( &(carrier->isSleeping), true, __ATOMIC_SEQ_CST );
+  if( __atomic_load_n( &(carrier->wakeEpoch), __ATOMIC_SEQ_CST ) == epoch )
+    Atomic_WaitThread( &(carrier->wakeEpoch), epoch, ATOMIC_TIME_INFINITE );
+  __atomic_store_n( &(carrier->isSleeping), false, __ATOMIC_RELAXED );
+}
+
+static inline ParkingBucket* GetParkingBucket( volatile uint32_t* address )
+{
+  uintptr_t key = (uintptr_t) address / sizeof(uint32_t);
+  return &(parkingLot[ ( key ^ ( key >> 6 ) ^ ( key >> 12 ) ) % PARKING_BUCKETS_COUNT ]);
+}
+
+bool Fibers_Park( volatile uint32_t* address, uint32_t expected )
+{
+  Fiber fiber = currentFiber;
+  if( fiber == NULL ) return false;
+  
+  ParkingBucket* bucket = GetParkingBucket( address );
+  AcquireSpinLock( &(bucket->lock) );
+  __atomic_store_n( &(bucket->waitersCount), bucket->waitersCount + 1, __ATOMIC_RELAXED );
+  // Either the waker sees the registration, or this check sees its change
+  __atomic_thread_fence( __ATOMIC_SEQ_CST );
+  if( __atomic_load_n( address, __ATOMIC_RELAXED ) != expected )
+  {
+    __atomic_store_n( &(bucket->waitersCount), bucket->waitersCount - 1, __ATOMIC_RELAXED );
+    ReleaseSpinLock( &(bucket->lock) );
+    return true;
+  }
+  fiber->parkAddress = address;
+  fiber->nextParked = bucket->waitersList;
+  bucket->waitersList = fiber;
+  ReleaseSpinLock( &(bucket->lock) );
+  
+  // Fibers never migrate, so an early wake only requeues it for its carrier, which is busy running it until this switch
+  SuspendFiber( true );
+  
+  return true;
+}
+
+void Fibers_Unpark( volatile uint32_t* address, bool all )
+{
+  ParkingBucket* bucket = GetParkingBucket( address );
+  
+  __atomic_thread_fence( __ATOMIC_SEQ_CST );
+  if( __atomic_load_n( &(bucket->waitersCount), __ATOMIC_RELAXED ) == 0 ) return;
+  
+  Fiber wokenList = NULL;
+  AcquireSpinLock( &(bucket->lock) );
+  Fiber* link = &(bucket->waitersList);
+  while( *link != NULL )
+  {
+    Fiber fiber = *link;
+    if( fiber->parkAddress != address ) 
+    {
+      link = &(fiber->nextParked);
+      continue;
+    }
+    *link = fiber->nextParked;
+    __atomic_store_n( &(bucket->waitersCount), bucket->waitersCount - 1, __ATOMIC_RELAXED );
+    fiber->nextParked = wokenList;
+    wokenList = fiber;
+    if( !all ) break;
+  }
+  ReleaseSpinLock( &(bucket->lock) );
+  
+  while( wokenList != NULL )
+  {
+    Fiber fiber = wokenList;
+    wokenList = fiber->nextParked;
+    PushFiber( fiber->carrier, fiber );
+    WakeCarrier( fiber->carrier );
+  }
+}
+
+static void* RunCarrier( void* args )
+{
+  Carrier* carrier = (Carrier*) args;
+  FiberScheduler scheduler = carrier->scheduler;
+  
+  if( !InitCarrierContext( carrier ) ) return NULL;
+  
+  while( true )
+  {
+    uint32_t epoch = __atomic_load_n( &(carrier->wakeEpoch), __ATOMIC_SEQ_CST );
+    
+    Fiber fiber = PopFiber( carrier );
+    if( fiber == NULL )
+    {
+      if( !__atomic_load_n( &(scheduler->isRunning), __ATOMIC_SEQ_CST ) && 
+          __atomic_load_n( &(scheduler->activeFibersCount), __ATOMIC_SEQ_CST ) == 0 ) break;
+      WaitCarrier( carrier, epoch );
+      continue;
+    }
+    
+    currentFiber = fiber;
+    fiber->isBlocked = false;
+    SwitchContext( &(carrier->context), &(fiber->context) );
+    currentFiber = NULL;
+    
+    if( fiber->isFinished )
+    {
+      DiscardContext( fiber );
+      free( fiber );
+      // Let all carriers check for shutdown after the last fiber
+      if( __atomic_sub_fetch( &(scheduler->activeFibersCount), 1, __ATOMIC_SEQ_CST ) == 0 )
+      {
+        for( size_t i = 0; i < scheduler->carriersCount; i++ )
+          WakeCarrier( &(scheduler->carriers[ i ]) );
+      }
+      continue;
+    }
+    
+    // Blocked fibers get requeued only when woken by Fibers_Unpark()
+    if( !fiber->isBlocked ) PushFiber( carrier, fiber );
+  }
+  
+  EndCarrierContext( carrier );
+  
+  return NULL;
+}
+
+FiberScheduler FiberScheduler_Create( size_t threadsCount, size_t stackSize )
+{
+  if( threadsCount == 0 ) return NULL;
+  
+  FiberScheduler scheduler = (FiberScheduler) malloc( sizeof(FiberSchedulerData) );
+  
+  scheduler->stackSize = ( stackSize > 0 ) ? stackSize : DEFAULT_STACK_SIZE;
+  scheduler->nextCarrier = 0;
+  scheduler->activeFibersCount = 0;
+  scheduler->isRunning = true;
+  
+  scheduler->carriers = (Carrier*) calloc( threadsCount, sizeof(Carrier) );
+  scheduler->carriersCount = threadsCount;
+  for( size_t i = 0; i < threadsCount; i++ )
+  {
+    Carrier* carrier = &(scheduler->carriers[ i ]);
+    carrier->scheduler = scheduler;
+    carrier->queueLock = 0;
+    carrier->queueLength = RUN_QUEUE_LENGTH_INCREMENT;
+    carrier->runQueue = (Fiber*) malloc( carrier->queueLength * sizeof(Fiber) );
+    carrier->queueFirst = carrier->queueCount = 0;
+    carrier->wakeEpoch = 0;
+    carrier->isSleeping = false;
+  }
+  
+  size_t startedCount = 0;
+  for( ; startedCount < threadsCount; startedCount++ )
+  {
+    Carrier* carrier = &(scheduler->carriers[ startedCount ]);
+    carrier->thread = Thread_Start( RunCarrier, (void*) carrier, THREAD_JOINABLE );
+    if( carrier->thread == THREAD_INVALID_HANDLE ) break;
+  }
+  
+  if( startedCount < threadsCount )
+  {
+    for( size_t i = startedCount; i < threadsCount; i++ )
+      free( scheduler->carriers[ i ].runQueue );
+    scheduler->carriersCount = startedCount;
+    FiberScheduler_Discard( scheduler );
+    return NULL;
+  }
+  
+  return scheduler;
+}
+
+void FiberScheduler_Discard( FiberScheduler scheduler )
+{
+  if( scheduler == NULL ) return;
+  
+  __atomic_store_n( &(scheduler->isRunning), false, __ATOMIC_SEQ_CST );
+  for( size_t i = 0; i < scheduler->carriersCount; i++ )
+    WakeCarrier( &(scheduler->carriers[ i ]) );
+  
+  for( size_t i = 0; i < scheduler->carriersCount; i++ )
+  {
+    Thread_WaitExit( scheduler->carriers[ i ].thread, INFINITE );
+    free( scheduler->carriers[ i ].runQueue );
+  }
+  free( scheduler->carriers );
+  
+  free( scheduler );
+}
+
+bool Fiber_Start( FiberScheduler scheduler, AsyncFunction function, void* args )
+{
+  if( scheduler == NULL || function == NULL ) return false;
+  
+  Fiber fiber = (Fiber) calloc( 1, sizeof(FiberData) );
+  fiber->stackSize = scheduler->stackSize;
+  fiber->function = function;
+  fiber->args = args;
+  fiber->isFinished = fiber->isBlocked = false;
+  if( !CreateContext( fiber ) )
+  {
+    free( fiber );
+    return false;
+  }
+  
+  __atomic_fetch_add( &(scheduler->activeFibersCount), 1, __ATOMIC_SEQ_CST );
+  
+  size_t carrierIndex = __atomic_fetch_add( &(scheduler->nextCarrier), 1, __ATOMIC_RELAXED ) % scheduler->carriersCount;
+  fiber->carrier = &(scheduler->carriers[ carrierIndex ]);
+  PushFiber( fiber->carrier, fiber );
+  WakeCarrier( fiber->carrier );
+  
+  return true;
+}
+
+void Fiber_Yield()
+{
+  if( currentFiber == NULL ) Atomic_Yield();
+  else SuspendFiber( false );
+}
+
+bool Fiber_IsRunning()
+{
+  return ( currentFiber != NULL );
+}
+
+// Blocking waits of these primitives go through Atomic_Wait(), which parks calling fiber until Atomic_Wake() on release/post
+
+void Fiber_AcquireLock( TLock lock )
+{
+  TLock_Acquire( lock );
+}
+
+void Fiber_DecrementSem( Semaphore sem )
+{
+  Sem_Decrement( sem );
+}
+
+bool Fiber_Dequeue( TSQueue queue, void* buffer )
+{
+  return TSQ_Dequeue( queue, buffer, TSQUEUE_WAIT );
+}
@@ -0,0 +1,85 @@
+//////////////////////////////////////////////////////////////////////////////////////
+//                                                                                  //
+//  Copyright (c) 2016-2025 Leonardo Consoni <leonardojc@protonmail.com>             //
+//                                                                                  //
+//  This file is part of Simple Multithreading.                                     //
+//                                                                                  //
+//  Simple Multithreading is free software: you can redistribute it and/or modify   //
+//  it under the terms of the GNU Lesser General Public License as published        //
+//  by the Free Software Foundation, either version 3 of the License, or            //
+//  (at your option) any later version.                                             //
+//                                                                                  //
+//  Simple Multithreading is distributed in the hope that it will be useful,        //
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of                  //
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                    //
+//  GNU Lesser General Public License for more details.                             //
+//                                                                                  //
+//  You should have received a copy of the GNU Lesser General Public License        //
+//  along with Simple Multithreading. If not, see <http://www.gnu.org/licenses/>.   //
+//                                                                                  //
+//////////////////////////////////////////////////////////////////////////////////////
+
+
+/// @file fibers.h
+/// @brief Lightweight user-space fibers multiplexed onto operating system threads.
+///
+/// M:N runtime of cooperative fibers (user-space threads with their own stacks) run by a set of carrier threads, 
+/// with fiber-aware versions of blocking calls that suspend only the calling fiber instead of its carrier thread.
+/// Any untimed blocking wait of this library's primitives made on a fiber is fiber-aware: the fiber is parked 
+/// until the release/post path wakes it, requeuing it on its carrier (timed waits and TLOCK_NATIVE locks still block the carrier)
+
+#ifndef FIBERS_H
+#define FIBERS_H
+
+#include "threads.h"
+#include "thread_locks.h"
+#include "semaphores.h"
+#include "thread_safe_queues.h"
+
+#include <stdbool.h>
+
+/// Structure holding single fiber scheduler data
+typedef struct _FiberSchedulerData FiberSchedulerData;
+/// Opaque reference to fiber scheduler data structure
+typedef FiberSchedulerData* FiberScheduler;
+
+                                                                            
+/// @brief Creates fiber scheduler data structure and starts its carrier threads                                               
+/// @param[in] threadsCount number of carrier (operating system) threads                                   
+/// @param[in] stackSize stack size (in bytes) of each started fiber (0 for default of 64 KB)                                  
+/// @return reference to newly created fiber scheduler (NULL on errors)
+FiberScheduler FiberScheduler_Create( size_t threadsCount, size_t stackSize );
+
+/// @brief Waits for all started fibers to finish, then stops carrier threads and deallocates given scheduler data
+/// @param[in] scheduler reference to fiber scheduler
+void FiberScheduler_Discard( FiberScheduler scheduler );
+
+/// @brief Starts new fiber to run the given method (fibers are evenly distributed among carriers, and never migrate)
+/// @param[in] scheduler reference to fiber scheduler
+/// @param[in] function pointer to the function that will run on the new fiber (its return value is ignored)
+/// @param[in] args opaque pointer to struct that will be passed as the function argument
+/// @return true on successful start, false otherwise
+bool Fiber_Start( FiberScheduler scheduler, AsyncFunction function, void* args );
+
+/// @brief Suspends calling fiber, letting other fibers of the same carrier run (yields thread when called outside fibers)
+void Fiber_Yield();
+
+/// @brief Checks if calling code is running on a fiber
+/// @return true if called from a fiber, false otherwise
+bool Fiber_IsRunning();
+
+/// @brief Fiber-aware TLock_Acquire(): suspends calling fiber (instead of its thread) until lock is released elsewhere (except for TLOCK_NATIVE locks)
+/// @param[in] lock mutex reference
+void Fiber_AcquireLock( TLock lock );
+
+/// @brief Fiber-aware Sem_Decrement(): suspends calling fiber (instead of its thread) until count is incremented from zero
+/// @param[in] sem reference to semaphore data structure
+void Fiber_DecrementSem( Semaphore sem );
+
+/// @brief Fiber-aware TSQ_Dequeue() with TSQUEUE_WAIT mode: suspends calling fiber (instead of its thread) until an item is enqueued
+/// @param[in] queue reference to queue
+/// @param[out] buffer opaque pointer to preallocated buffer for variable
+/// @return true on successful copy/removal, false otherwise 
+bool Fiber_Dequeue( TSQueue queue, void* buffer );
+
+#endif // FIBERS_H
@@ -0,0 +1,181 @@
+//////////////////////////////////////////////////////////////////////////////////////
+//                                                                                  //
+//  Copyright (c) 2016-2025 Leonardo Consoni <leonardojc@protonmail.com>            //
+//                                                                                  //
+//  This file is part of Simple Multithreading.                                     //
+//                                                                                  //
+//  Simple Multithreading is free software: you can redistribute it and/or modify   //
+//  it under the terms of the GNU Lesser General Public License as published        //
+//  by the Free Software Foundation, either version 3 of the License, or            //
+//  (at your option) any later version.                                             //
+//                                                                                  //
+//  Simple Multithreading is distributed in the hope that it will be useful,        //
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of                  //
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                    //
+//  GNU Lesser General Public License for more details.                             //
+//                                                                                  //
+//  You should have received a copy of the GNU Lesser General Public License        //
+//  along with Simple Multithreading. If not, see <http://www.gnu.org/licenses/>.   //
+//                                                                                  //
+//////////////////////////////////////////////////////////////////////////////////////
+
+#include "thread_atomics.h"
+#include "task_schedulers.h"
+
+#include "parallel_loops.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct _LoopData
+{
+  size_t begin, end, grain;
+  enum ParallelSchedule schedule;
+  size_t participantsCount;
+  volatile size_t nextIndex;
+  volatile size_t nextParticipant;
+  ParallelForFunction forFunction;
+  ParallelReduceFunction reduceFunction;
+  void* context;
+  uint8_t* accumulators;
+  size_t accumulatorStride;
+}
+LoopData;
+
+
+// Takes next chunk of the range for given participant, returning false when the range is exhausted
+static bool GetChunk( LoopData* loop, size_t participant, size_t* chunkBegin, size_t* chunkEnd )
+{
+  size_t rangeLength = loop->end - loop->begin;
+  
+  if( loop->schedule == PARALLEL_STATIC )
+  {
+    if( *chunkEnd != 0 ) return false;   // Single block per participant
+    *chunkBegin = loop->begin + rangeLength * participant / loop->participantsCount;
+    *chunkEnd = loop->begin + rangeLength * ( participant + 1 ) / loop->participantsCount;
+    return ( *chunkBegin < *chunkEnd );
+  }
+  
+  size_t first = __atomic_load_n( &(loop->nextIndex), __ATOMIC_RELAXED );
+  size_t chunkLength;
+  do
+  {
+    if( first >= loop->end ) return false;
+    chunkLength = loop->grain;
+    if( loop->schedule == PARALLEL_GUIDED )
+    {
+      size_t guidedLength = ( loop->end - first ) / ( 2 * loop->participantsCount );
+      if( guidedLength > chunkLength ) chunkLength = guidedLength;
+    }
+    if( chunkLength > loop->end - first ) chunkLength = loop->end - first;
+  }
+  while( !__atomic_compare_exchange_n( &(loop->nextIndex), &first, first + chunkLength, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED ) );
+  
+  *chunkBegin = first;
+  *chunkEnd = first + chunkLength;
+  
+  return true;
+}
+
+static void* RunParticipant( void* args )
+{
+  LoopData* loop = (LoopData*) args;
+  
+  size_t participant = __atomic_fetch_add( &(loop->nextParticipant), 1, __ATOMIC_RELAXED );
+  void* accumulator = ( loop->accumulators != NULL ) ? loop->accumulators + participant * loop->accumulatorStride : NULL;
+  
+  size_t chunkBegin = 0, chunkEnd = 0;
+  while( GetChunk( loop, participant, &chunkBegin, &chunkEnd ) )
+  {
+    if( loop->reduceFunction != NULL ) loop->reduceFunction( chunkBegin, chunkEnd, loop->context, accumulator );
+    else loop->forFunction( chunkBegin, chunkEnd, loop->context );
+  }
+  
+  return NULL;
+}
+
+// Runs loop participants on scheduler workers and calling thread
+static void RunLoop( LoopData* loop )
+{
+  TaskScheduler scheduler = TaskScheduler_GetDefault();
+  TaskCounter pendingCount = 0;
+  
+  for( size_t i = 1; i < loop->participantsCount; i++ )
+    TaskScheduler_Spawn( scheduler, RunParticipant, (void*) loop, &pendingCount );
+  RunParticipant( (void*) loop );
+  TaskScheduler_Join( scheduler, &pendingCount );
+}
+
+// Number of threads worth using for given range, bounded by scheduler workers plus caller
+static size_t GetParticipantsCount( size_t rangeLength, size_t grain )
+{
+  size_t chunksCount = ( rangeLength + grain - 1 ) / grain;
+  size_t threadsCount = TaskScheduler_GetWorkersCount( TaskScheduler_GetDefault() ) + 1;
+  
+  return ( chunksCount < threadsCount ) ? chunksCount : threadsCount;
+}
+
+void Parallel_For( size_t begin, size_t end, size_t grain, enum ParallelSchedule schedule, ParallelForFunction function, void* context )
+{
+  if( function == NULL || begin >= end ) return;
+  
+  if( grain == 0 ) grain = 1;
+  
+  size_t participantsCount = GetParticipantsCount( end - begin, grain );
+  if( participantsCount <= 1 )
+  {
+    function( begin, end, context );
+    return;
+  }
+  
+  LoopData loop = { .begin = begin, .end = end, .grain = grain, .schedule = schedule, .participantsCount = participantsCount,
+                    .nextIndex = begin, .nextParticipant = 0, .forFunction = function, .reduceFunction = NULL, .context = context,
+                    .accumulators = NULL, .accumulatorStride = 0 };
+  RunLoop( &loop );
+}
+
+void Parallel_Reduce( size_t begin, size_t end, size_t grain, enum ParallelSchedule schedule, 
+                      ParallelReduceFunction function, ParallelJoinFunction join, void* context, void* result, size_t resultSize )
+{
+  if( function == NULL || join == NULL || result == NULL || begin >= end ) return;
+  
+  if( grain == 0 ) grain = 1;
+  
+  size_t participantsCount = GetParticipantsCount( end - begin, grain );
+  if( participantsCount <= 1 )
+  {
+    function( begin, end, context, result );
+    return;
+  }
+  
+  // Partial results of different threads are kept on separate cache lines
+  size_t accumulatorStride = ( resultSize + ATOMIC_CACHE_LINE_SIZE - 1 ) / ATOMIC_CACHE_LINE_SIZE * ATOMIC_CACHE_LINE_SIZE;
+  uint8_t* accumulators = NULL;
+#ifdef WIN32
+  accumulators = (uint8_t*) _aligned_malloc( participantsCount * accumulatorStride, ATOMIC_CACHE_LINE_SIZE );
+#else
+  if( posix_memalign( (void**) &accumulators, ATOMIC_CACHE_LINE_SIZE, participantsCount * accumulatorStride ) != 0 ) accumulators = NULL;
+#endif
+  if( accumulators == NULL )
+  {
+    function( begin, end, context, result );
+    return;
+  }
+  for( size_t i = 0; i < participantsCount; i++ )
+    memcpy( accumulators + i * accumulatorStride, result, resultSize );
+  
+  LoopData loop = { .begin = begin, .end = end, .grain = grain, .schedule = schedule, .participantsCount = participantsCount,
+                    .nextIndex = begin, .nextParticipant = 0, .forFunction = NULL, .reduceFunction = function, .context = context,
+                    .accumulators = accumulators, .accumulatorStride = accumulatorStride };
+  RunLoop( &loop );
+  
+  for( size_t i = 0; i < participantsCount; i++ )
+    join( result, accumulators + i * accumulatorStride, context );
+  
+#ifdef WIN32
+  _aligned_free( accumulators );
+#else
+  free( accumulators );
+#endif
+}
@@ -0,0 +1,72 @@
+//////////////////////////////////////////////////////////////////////////////////////
+//                                                                                  //
+//  Copyright (c) 2016-2025 Leonardo Consoni <leonardojc@protonmail.com>             //
+//                                                                                  //
+//  This file is part of Simple Multithreading.                                     //
+//                                                                                  //
+//  Simple Multithreading is free software: you can redistribute it and/or modify   //
+//  it under the terms of the GNU Lesser General Public License as published        //
+//  by the Free Software Foundation, either version 3 of the License, or            //
+//  (at your option) any later version.                                             //
+//                                                                                  //
+//  Simple Multithreading is distributed in the hope that it will be useful,        //
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of                  //
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                    //
+//  GNU Lesser General Public License for more details.                             //
+//                                                                                  //
+//  You should have received a copy of the GNU Lesser General Public License        //
+//  along with Simple Multithreading. If not, see <http://www.gnu.org/licenses/>.   //
+//                                                                                  //
+//////////////////////////////////////////////////////////////////////////////////////
+
+
+/// @file parallel_loops.h
+/// @brief Parallel loops (for and reduce) over index ranges.
+///
+/// Splitting of index ranges in chunks run concurrently by the default task scheduler workers 
+/// and by the calling thread, with static, dynamic or guided chunk scheduling
+
+#ifndef PARALLEL_LOOPS_H
+#define PARALLEL_LOOPS_H
+
+#include <stddef.h>
+
+/// Policy for distributing index range chunks among participating threads
+enum ParallelSchedule
+{
+  PARALLEL_STATIC,           ///< Range evenly split upfront, one contiguous block per thread (lowest overhead, for uniform iterations)
+  PARALLEL_DYNAMIC,          ///< Chunks of grain size taken on demand (for irregular iterations)
+  PARALLEL_GUIDED            ///< Chunks taken on demand, with sizes decreasing from a fraction of the remaining range down to grain size
+};
+
+/// Signature/type required for functions run over index range chunks (end index is excluded)
+typedef void (*ParallelForFunction)( size_t begin, size_t end, void* context );
+/// Signature/type required for functions accumulating results over index range chunks (end index is excluded)
+typedef void (*ParallelReduceFunction)( size_t begin, size_t end, void* context, void* accumulator );
+/// Signature/type required for functions merging a partial result into an accumulated one (should be associative and commutative)
+typedef void (*ParallelJoinFunction)( void* accumulator, const void* partial, void* context );
+
+                                                                            
+/// @brief Runs given function over index range chunks in parallel, returning after the whole range is processed                                               
+/// @param[in] begin first index of the range                                   
+/// @param[in] end index after the last one of the range                                   
+/// @param[in] grain minimum number of indexes per chunk (0 for 1)                                   
+/// @param[in] schedule chunks distribution policy (PARALLEL_STATIC, PARALLEL_DYNAMIC or PARALLEL_GUIDED)                                   
+/// @param[in] function pointer to the function run for each chunk                                   
+/// @param[in] context opaque pointer to struct that will be passed to the function
+void Parallel_For( size_t begin, size_t end, size_t grain, enum ParallelSchedule schedule, ParallelForFunction function, void* context );
+
+/// @brief Accumulates results over index range chunks in parallel, merging per-thread partial results afterwards                                               
+/// @param[in] begin first index of the range                                   
+/// @param[in] end index after the last one of the range                                   
+/// @param[in] grain minimum number of indexes per chunk (0 for 1)                                   
+/// @param[in] schedule chunks distribution policy (PARALLEL_STATIC, PARALLEL_DYNAMIC or PARALLEL_GUIDED)                                   
+/// @param[in] function pointer to the function accumulating each chunk results into a per-thread partial result                                   
+/// @param[in] join pointer to the function merging partial results                                   
+/// @param[in] context opaque pointer to struct that will be passed to both functions
+/// @param[in,out] result pointer to variable holding the identity (neutral) value on call and the reduced value on return
+/// @param[in] resultSize size (in bytes) of result variable
+void Parallel_Reduce( size_t begin, size_t end, size_t grain, enum ParallelSchedule schedule, 
+                      ParallelReduceFunction function, ParallelJoinFunction join, void* context, void* result, size_t resultSize );
+
+#endif // PARALLEL_LOOPS_H
@@ -0,0 +1,200 @@
+//////////////////////////////////////////////////////////////////////////////////////
+//                                                                                  //
+//  Copyright (c) 2016-2025 Leonardo Consoni <leonardojc@protonmail.com>            //
+//                                                                                  //
+//  This file is part of Simple Multithreading.                                     //
+//                                                                                  //
+//  Simple Multithreading is free software: you can redistribute it and/or modify   //
+//  it under the terms of the GNU Lesser General Public License as published        //
+//  by the Free Software Foundation, either version 3 of the License, or            //
+//  (at your option) any later version.                                             //
+//                                                                                  //
+//  Simple Multithreading is distributed in the hope that it will be useful,        //
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of                  //
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                    //
+//  GNU Lesser General Public License for more details.                             //
+//                                                                                  //
+//  You should have received a copy of the GNU Lesser General Public License        //
+//  along with Simple Multithreading. If not, see <http://www.gnu.org/licenses/>.   //
+//                                                                                  //
+//////////////////////////////////////////////////////////////////////////////////////
+
+#include "thread_atomics.h"
+
+#include "periodic_tasks.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct _TimingRecord
+{
+  volatile uint64_t total, max;
+  volatile uint64_t bins[ PERIODIC_TASK_HISTOGRAM_LENGTH ];
+}
+TimingRecord;
+
+struct _PeriodicTaskData
+{
+  PeriodicFunction function;
+  void* args;
+  uint64_t period;
+  Thread thread;
+  volatile bool isRunning;
+  volatile uint64_t cyclesCount, missedDeadlinesCount;
+  TimingRecord records[ 2 ];
+};
+
+
+#ifdef WIN32
+
+#include <Windows.h>
+
+// Sleep until given monotonic time (in nanoseconds)
+static void SleepUntil( uint64_t deadline )
+{
+  static THREAD_LOCAL HANDLE timer = NULL;
+  if( timer == NULL ) timer = CreateWaitableTimerEx( NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS );
+  
+  uint64_t now = Atomic_GetTime();
+  if( now >= deadline ) return;
+  // Relative due time, in 100 nanoseconds units
+  LARGE_INTEGER dueTime = { .QuadPart = -(LONGLONG) ( ( deadline - now ) / 100 ) };
+  SetWaitableTimer( timer, &dueTime, 0, NULL, NULL, FALSE );
+  WaitForSingleObject( timer, INFINITE );
+}
+
+#else // Unix
+
+#include <time.h>
+#include <errno.h>
+
+// Sleep until given monotonic time (in nanoseconds)
+static void SleepUntil( uint64_t deadline )
+{
+  struct timespec wakeTime = { .tv_sec = (time_t) ( deadline / 1000000000 ), .tv_nsec = (long) ( deadline % 1000000000 ) };
+  while( clock_nanosleep( CLOCK_MONOTONIC, TIMER_ABSTIME, &wakeTime, NULL ) == EINTR );
+}
+
+#endif // WIN32
+
+// Records single timing measure (only the task thread writes, but readers and resets may run concurrently)
+static void RecordTiming( TimingRecord* record, uint64_t value )
+{
+  size_t binIndex = 0;
+  while( ( value >> ( binIndex + 1 ) ) > 0 && binIndex < PERIODIC_TASK_HISTOGRAM_LENGTH - 1 ) binIndex++;
+  __atomic_fetch_add( &(record->bins[ binIndex ]), 1, __ATOMIC_RELAXED );
+  
+  __atomic_fetch_add( &(record->total), value, __ATOMIC_RELAXED );
+  
+  uint64_t maxValue = __atomic_load_n( &(record->max), __ATOMIC_RELAXED );
+  while( value > maxValue && !__atomic_compare_exchange_n( &(record->max), &maxValue, value, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED ) );
+}
+
+static void* RunCycles( void* args )
+{
+  PeriodicTask task = (PeriodicTask) args;
+  
+  uint64_t deadline = Atomic_GetTime() + task->period;
+  while( __atomic_load_n( &(task->isRunning), __ATOMIC_RELAXED ) )
+  {
+    SleepUntil( deadline );
+    
+    uint64_t wakeTime = Atomic_GetTime();
+    bool keepRunning = task->function( task->args );
+    uint64_t endTime = Atomic_GetTime();
+    
+    RecordTiming( &(task->records[ PERIODIC_TASK_LATENCY ]), ( wakeTime > deadline ) ? wakeTime - deadline : 0 );
+    RecordTiming( &(task->records[ PERIODIC_TASK_EXECUTION ]), endTime - wakeTime );
+    __atomic_fetch_add( &(task->cyclesCount), 1, __ATOMIC_RELAXED );
+    
+    deadline += task->period;
+    if( endTime > deadline )
+    {
+      __atomic_fetch_add( &(task->missedDeadlinesCount), 1, __ATOMIC_RELAXED );
+      // Skip whole missed periods instead of running late cycles back to back
+      deadline += ( ( endTime - deadline ) / task->period + 1 ) * task->period;
+    }
+    
+    if( !keepRunning ) __atomic_store_n( &(task->isRunning), false, __ATOMIC_RELAXED );
+  }
+  
+  return NULL;
+}
+
+PeriodicTask PeriodicTask_Start( PeriodicFunction function, void* args, unsigned long periodMicroseconds, const ThreadAttributes* attributes )
+{
+  if( function == NULL || periodMicroseconds == 0 ) return NULL;
+  
+  PeriodicTask task = (PeriodicTask) calloc( 1, sizeof(PeriodicTaskData) );
+  
+  task->function = function;
+  task->args = args;
+  task->period = (uint64_t) periodMicroseconds * 1000;
+  task->isRunning = true;
+  
+  if( (task->thread = Thread_StartEx( RunCycles, (void*) task, THREAD_JOINABLE, attributes )) == THREAD_INVALID_HANDLE )
+  {
+    free( task );
+    return NULL;
+  }
+  
+  return task;
+}
+
+void PeriodicTask_Stop( PeriodicTask task )
+{
+  if( task == NULL ) return;
+  
+  __atomic_store_n( &(task->isRunning), false, __ATOMIC_RELAXED );
+  Thread_WaitExit( task->thread, INFINITE );
+  
+  free( task );
+}
+
+bool PeriodicTask_IsRunning( PeriodicTask task )
+{
+  if( task == NULL ) return false;
+  
+  return __atomic_load_n( &(task->isRunning), __ATOMIC_RELAXED );
+}
+
+bool PeriodicTask_GetStats( PeriodicTask task, PeriodicTaskStats* stats )
+{
+  if( task == NULL || stats == NULL ) return false;
+  
+  stats->cyclesCount = __atomic_load_n( &(task->cyclesCount), __ATOMIC_RELAXED );
+  stats->missedDeadlinesCount = __atomic_load_n( &(task->missedDeadlinesCount), __ATOMIC_RELAXED );
+  stats->maxLatency = __atomic_load_n( &(task->records[ PERIODIC_TASK_LATENCY ].max), __ATOMIC_RELAXED );
+  stats->maxExecutionTime = __atomic_load_n( &(task->records[ PERIODIC_TASK_EXECUTION ].max), __ATOMIC_RELAXED );
+  stats->totalLatency = __atomic_load_n( &(task->records[ PERIODIC_TASK_LATENCY ].total), __ATOMIC_RELAXED );
+  stats->totalExecutionTime = __atomic_load_n( &(task->records[ PERIODIC_TASK_EXECUTION ].total), __ATOMIC_RELAXED );
+  
+  return true;
+}
+
+bool PeriodicTask_GetHistogram( PeriodicTask task, enum PeriodicTaskMeasure measure, uint64_t* bins )
+{
+  if( task == NULL || bins == NULL ) return false;
+  if( measure != PERIODIC_TASK_LATENCY && measure != PERIODIC_TASK_EXECUTION ) return false;
+  
+  for( size_t binIndex = 0; binIndex < PERIODIC_TASK_HISTOGRAM_LENGTH; binIndex++ )
+    bins[ binIndex ] = __atomic_load_n( &(task->records[ measure ].bins[ binIndex ]), __ATOMIC_RELAXED );
+  
+  return true;
+}
+
+void PeriodicTask_ResetStats( PeriodicTask task )
+{
+  if( task == NULL ) return;
+  
+  __atomic_store_n( &(task->cyclesCount), 0, __ATOMIC_RELAXED );
+  __atomic_store_n( &(task->missedDeadlinesCount), 0, __ATOMIC_RELAXED );
+  for( size_t recordIndex = 0; recordIndex < 2; recordIndex++ )
+  {
+    TimingRecord* record = &(task->records[ recordIndex ]);
+    __atomic_store_n( &(record->total), 0, __ATOMIC_RELAXED );
+    __atomic_store_n( &(record->max), 0, __ATOMIC_RELAXED );
+    for( size_t binIndex = 0; binIndex < PERIODIC_TASK_HISTOGRAM_LENGTH; binIndex++ )
+      __atomic_store_n( &(record->bins[ binIndex ]), 0, __ATOMIC_RELAXED );
+  }
+}
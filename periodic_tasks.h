@@ -0,0 +1,100 @@
+//////////////////////////////////////////////////////////////////////////////////////
+//                                                                                  //
+//  Copyright (c) 2016-2025 Leonardo Consoni <leonardojc@protonmail.com>             //
+//                                                                                  //
+//  This file is part of Simple Multithreading.                                     //
+//                                                                                  //
+//  Simple Multithreading is free software: you can redistribute it and/or modify   //
+//  it under the terms of the GNU Lesser General Public License as published        //
+//  by the Free Software Foundation, either version 3 of the License, or            //
+//  (at your option) any later version.                                             //
+//                                                                                  //
+//  Simple Multithreading is distributed in the hope that it will be useful,        //
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of                  //
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                    //
+//  GNU Lesser General Public License for more details.                             //
+//                                                                                  //
+//  You should have received a copy of the GNU Lesser General Public License        //
+//  along with Simple Multithreading. If not, see <http://www.gnu.org/licenses/>.   //
+//                                                                                  //
+//////////////////////////////////////////////////////////////////////////////////////
+
+
+/// @file periodic_tasks.h
+/// @brief Fixed rate (periodic) real-time thread runner.
+///
+/// Threads that call a function on a fixed period using absolute deadlines (so that waiting does not drift),
+/// recording wake-up latency, execution time and missed deadlines statistics that can be queried at runtime
+
+#ifndef PERIODIC_TASKS_H
+#define PERIODIC_TASKS_H
+
+#include "threads.h"
+
+#include <stdbool.h>
+
+#define PERIODIC_TASK_HISTOGRAM_LENGTH 32     ///< Number of (power of 2 nanoseconds) bins of timing histograms
+
+/// Structure holding single periodic task data
+typedef struct _PeriodicTaskData PeriodicTaskData;
+/// Opaque reference to periodic task data structure
+typedef PeriodicTaskData* PeriodicTask;
+
+/// Signature/type required for functions run periodically (returning false stops the task)
+typedef bool (*PeriodicFunction)( void* );
+
+/// Timing measurement recorded on each task cycle
+enum PeriodicTaskMeasure
+{
+  PERIODIC_TASK_LATENCY,         ///< Delay (in nanoseconds) between cycle deadline and thread wake-up
+  PERIODIC_TASK_EXECUTION        ///< Time (in nanoseconds) spent running the periodic function
+};
+
+/// Snapshot of periodic task timing statistics
+typedef struct _PeriodicTaskStats
+{
+  uint64_t cyclesCount;                    ///< Number of completed cycles
+  uint64_t missedDeadlinesCount;           ///< Number of cycles that ended after the next cycle deadline
+  uint64_t maxLatency;                     ///< Maximum wake-up latency (in nanoseconds)
+  uint64_t maxExecutionTime;               ///< Maximum execution time (in nanoseconds)
+  uint64_t totalLatency;                   ///< Sum of all wake-up latencies (in nanoseconds)
+  uint64_t totalExecutionTime;             ///< Sum of all execution times (in nanoseconds)
+}
+PeriodicTaskStats;
+
+                                                                            
+/// @brief Setups new thread to run the given method at a fixed period                                               
+/// @param[in] function pointer to the function that will run on each cycle                                   
+/// @param[in] args opaque pointer to struct that will be passed as the function argument                                         
+/// @param[in] periodMicroseconds cycle period (in microseconds)       
+/// @param[in] attributes pointer to thread creation attributes, e.g. for real-time priority and affinity (NULL for system defaults)       
+/// @return reference to newly created periodic task (NULL on errors)  
+PeriodicTask PeriodicTask_Start( PeriodicFunction function, void* args, unsigned long periodMicroseconds, const ThreadAttributes* attributes );
+
+/// @brief Stops given periodic task (after its current cycle) and deallocates its data
+/// @param[in] task reference to periodic task
+void PeriodicTask_Stop( PeriodicTask task );
+
+/// @brief Checks if given periodic task is still running (its function has not returned false)
+/// @param[in] task reference to periodic task
+/// @return true if running, false otherwise
+bool PeriodicTask_IsRunning( PeriodicTask task );
+
+/// @brief Reads current timing statistics of given periodic task (safe to call while it runs)
+/// @param[in] task reference to periodic task
+/// @param[out] stats pointer to statistics structure
+/// @return true on successful reading, false otherwise
+bool PeriodicTask_GetStats( PeriodicTask task, PeriodicTaskStats* stats );
+
+/// @brief Reads current histogram of given timing measure (bin i counts values in the [2^i,2^(i+1)) nanoseconds range, with bin 0 also counting 0)
+/// @param[in] task reference to periodic task
+/// @param[in] measure histogram measurement (PERIODIC_TASK_LATENCY or PERIODIC_TASK_EXECUTION)
+/// @param[out] bins array for PERIODIC_TASK_HISTOGRAM_LENGTH counts
+/// @return true on successful reading, false otherwise
+bool PeriodicTask_GetHistogram( PeriodicTask task, enum PeriodicTaskMeasure measure, uint64_t* bins );
+
+/// @brief Clears timing statistics and histograms of given periodic task
+/// @param[in] task reference to periodic task
+void PeriodicTask_ResetStats( PeriodicTask task );
+
+#endif // PERIODIC_TASKS_H
@@ -19,141 +19,201 @@
 //                                                                                  //
 //////////////////////////////////////////////////////////////////////////////////////
 
-#include "semaphores.h"
+#include "thread_atomics.h"
 
-#ifdef WIN32
+#include "semaphores.h"
 
-#include <Windows.h>
 #include <stdlib.h>
 
+// Count and waiters of both directions share a single 64-bit word, so that every operation is a single 
+// atomic update which also tells if anybody needs to be awaken. Threads block (futex) on its count half.
+// Each direction holds up to 65535 registered waiters: further ones keep yielding instead of blocking
+#define COUNT_MASK 0xFFFFFFFFULL
+#define DOWN_WAITER ( 1ULL << 32 )
+#define UP_WAITER ( 1ULL << 48 )
+#define DOWN_WAITERS_MASK ( 0xFFFFULL << 32 )
+#define UP_WAITERS_MASK ( 0xFFFFULL << 48 )
+
+#define MAX_COUNT 0xFFFFFFFF
+#define SPIN_COUNT 100
+#define NO_WAIT_DEADLINE 0
+
 struct _SemaphoreData
 {
-  HANDLE counter;
-  size_t count, maxCount;
+  volatile uint64_t state;
+  uint32_t maxCount;
+  volatile uint32_t batchWaitersCount;
 };
 
-Semaphore Sem_Create( size_t startCount, size_t maxCount )
+// Fails to compile if semaphore data doesn't fit on storage size exposed to users, or doesn't match its static initializer
+typedef char SemaphoreStorageSizeCheck[ ( sizeof(SemaphoreData) <= sizeof(SemaphoreStorage) ) ? 1 : -1 ];
+typedef char SemaphoreStorageLayoutCheck[ ( offsetof(SemaphoreData, maxCount) == offsetof(SemaphoreStorage, initialValues.maxCount) ) ? 1 : -1 ];
+
+static inline volatile uint32_t* GetCountWord( Semaphore sem )
 {
-  Semaphore sem = (Semaphore) malloc( sizeof(SemaphoreData) );
-  sem->counter = CreateSemaphore( NULL, startCount, maxCount, NULL );
-  sem->count = startCount;
-  sem->maxCount = maxCount;
+#if defined( __BYTE_ORDER__ ) && ( __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__ )
+  return (volatile uint32_t*) &(sem->state) + 1;
+#else
+  return (volatile uint32_t*) &(sem->state);
+#endif
+}
+
+// Awakes waiters blocked in the opposite direction of a successful update, given the resulting state. 
+// Waking only one is safe only if it can surely be satisfied (single unit waiters of a single direction)
+static void WakeWaiters( Semaphore sem, uint64_t state, int64_t delta )
+{
+  uint64_t waitersMask = ( delta > 0 ) ? DOWN_WAITERS_MASK : UP_WAITERS_MASK;
+  if( ( state & waitersMask ) == 0 ) return;
   
-  return sem;
+  bool wakeAll = ( delta > 1 || delta < -1 || ( state & ~waitersMask & ~COUNT_MASK ) != 0 || 
+                   __atomic_load_n( &(sem->batchWaitersCount), __ATOMIC_SEQ_CST ) > 0 );
+  Atomic_Wake( GetCountWord( sem ), wakeAll );
 }
 
-void Sem_Discard( Semaphore sem )
+// Adds given (possibly negative) delta to count, waiting until deadline for the result to be between 0 and maximum count
+static bool UpdateCount( Semaphore sem, int64_t delta, uint64_t deadline )
 {
-  CloseHandle( sem->counter );
-  free( sem );
+  uint64_t waiterIncrement = ( delta > 0 ) ? UP_WAITER : DOWN_WAITER;
+  uint64_t waitersMask = ( delta > 0 ) ? UP_WAITERS_MASK : DOWN_WAITERS_MASK;
+  bool isBatch = ( delta > 1 || delta < -1 );
+  size_t spinsCount = 0;
+  bool isTimedOut = false;
+  
+  uint64_t state = __atomic_load_n( &(sem->state), __ATOMIC_RELAXED );
+  while( true )
+  {
+    uint32_t count = (uint32_t) ( state & COUNT_MASK );
+    int64_t newCount = (int64_t) count + delta;
+    if( newCount >= 0 && newCount <= (int64_t) sem->maxCount )
+    {
+      if( __atomic_compare_exchange_n( &(sem->state), &state, state + (uint64_t) delta, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED ) )
+      {
+        WakeWaiters( sem, state + (uint64_t) delta, delta );
+        return true;
+      }
+      continue;
+    }
+    
+    if( deadline == NO_WAIT_DEADLINE || isTimedOut ) return false;
+    
+    if( spinsCount++ < SPIN_COUNT )
+    {
+      Atomic_Pause();
+      state = __atomic_load_n( &(sem->state), __ATOMIC_RELAXED );
+      continue;
+    }
+    
+    // Waiters field full: registering would carry into the next one
+    if( ( state & waitersMask ) == waitersMask )
+    {
+      Atomic_Yield();
+      isTimedOut = ( deadline != ATOMIC_TIME_INFINITE && Atomic_GetTime() >= deadline );
+      state = __atomic_load_n( &(sem->state), __ATOMIC_RELAXED );
+      continue;
+    }
+    
+    // Registering as waiter first makes updaters aware of it (and of batch waiters, which need all waiters awaken), 
+    // and blocking fails if count changed meanwhile
+    if( isBatch ) __atomic_fetch_add( &(sem->batchWaitersCount), 1, __ATOMIC_SEQ_CST );
+    if( __atomic_compare_exchange_n( &(sem->state), &state, state + waiterIncrement, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED ) )
+    {
+      isTimedOut = !Atomic_Wait( GetCountWord( sem ), count, deadline );
+      state = __atomic_sub_fetch( &(sem->state), waiterIncrement, __ATOMIC_SEQ_CST );
+    }
+    if( isBatch ) __atomic_fetch_sub( &(sem->batchWaitersCount), 1, __ATOMIC_SEQ_CST );
+  }
 }
 
-void Sem_Increment( Semaphore sem )
+Semaphore Sem_Init( SemaphoreStorage* storage, size_t startCount, size_t maxCount )
 {
-  ReleaseSemaphore( sem->counter, 1, &(sem->count) );
-  sem->count++;  
+  if( storage == NULL ) return NULL;
+  
+  Semaphore sem = (Semaphore) storage;
+  sem->maxCount = ( maxCount < MAX_COUNT ) ? (uint32_t) maxCount : MAX_COUNT;
+  sem->state = ( startCount < sem->maxCount ) ? startCount : sem->maxCount;
+  sem->batchWaitersCount = 0;
+  
+  return sem;
 }
 
-void Sem_Decrement( Semaphore sem )
+void Sem_Destroy( Semaphore sem )
 {
-  WaitForSingleObject( sem->counter, INFINITE );
-  sem->count--;
+  (void) sem;
 }
 
-size_t Sem_GetCount( Semaphore sem )
+Semaphore Sem_Create( size_t startCount, size_t maxCount )
 {
-  if( sem == NULL ) return 0;
-  
-  return sem->count;
+  return Sem_Init( (SemaphoreStorage*) malloc( sizeof(SemaphoreStorage) ), startCount, maxCount );
 }
 
-void Sem_SetCount( Semaphore sem, size_t count )
+void Sem_Discard( Semaphore sem )
 {
   if( sem == NULL ) return;
   
-  if( count > sem->maxCount ) count = sem->maxCount;
-
-  size_t countDelta = (size_t) abs( (int) count - (int) sem->count );
-  if( count > sem->count )
-  {
-    for( size_t i = 0; i < countDelta; i++ )
-      Sem_Increment( sem );
-  }  
-  else if( count < sem->count )
-  {
-    for( size_t i = 0; i < countDelta; i++ )
-      Sem_Decrement( sem ); 
-  }
+  Sem_Destroy( sem );
+  free( sem );
 }
 
-#else // Unix
-
-#include <semaphore.h>
-#include <stdlib.h>
-#include <malloc.h>
+void Sem_Increment( Semaphore sem )
+{
+  UpdateCount( sem, 1, ATOMIC_TIME_INFINITE );
+}
 
-struct _SemaphoreData
+void Sem_Decrement( Semaphore sem )
 {
-  sem_t upCounter;
-  sem_t downCounter;
-  size_t maxCount;
-};
+  UpdateCount( sem, -1, ATOMIC_TIME_INFINITE );
+}
 
-Semaphore Sem_Create( size_t startCount, size_t maxCount )
+void Sem_IncrementBy( Semaphore sem, size_t count )
 {
-  Semaphore sem = (Semaphore) malloc( sizeof(SemaphoreData) );
-  sem_init( &(sem->upCounter), 0, maxCount - startCount );
-  sem_init( &(sem->downCounter), 0, startCount );
+  if( count == 0 || count > sem->maxCount ) return;
   
-  sem->maxCount = maxCount;
+  UpdateCount( sem, (int64_t) count, ATOMIC_TIME_INFINITE );
+}
+
+void Sem_DecrementBy( Semaphore sem, size_t count )
+{
+  if( count == 0 || count > sem->maxCount ) return;
   
-  return sem;
+  UpdateCount( sem, -(int64_t) count, ATOMIC_TIME_INFINITE );
 }
 
-void Sem_Discard( Semaphore sem )
+bool Sem_TryDecrement( Semaphore sem )
 {
-  sem_destroy( &(sem->upCounter) );
-  sem_destroy( &(sem->downCounter) );
-  free( sem );
+  return UpdateCount( sem, -1, NO_WAIT_DEADLINE );
 }
 
-void Sem_Increment( Semaphore sem )
+bool Sem_DecrementTimed( Semaphore sem, unsigned int milliseconds )
 {
-  sem_wait( &(sem->upCounter) );
-  sem_post( &(sem->downCounter) );  
+  return UpdateCount( sem, -1, ( milliseconds == 0 ) ? NO_WAIT_DEADLINE : Atomic_GetDeadline( milliseconds ) );
 }
 
-void Sem_Decrement( Semaphore sem )
+bool Sem_TryIncrement( Semaphore sem )
+{
+  return UpdateCount( sem, 1, NO_WAIT_DEADLINE );
+}
+
+bool Sem_IncrementTimed( Semaphore sem, unsigned int milliseconds )
 {
-  sem_wait( &(sem->downCounter) );
-  sem_post( &(sem->upCounter) ); 
+  return UpdateCount( sem, 1, ( milliseconds == 0 ) ? NO_WAIT_DEADLINE : Atomic_GetDeadline( milliseconds ) );
 }
 
 size_t Sem_GetCount( Semaphore sem )
 {
-  int countValue;
-  sem_getvalue( &(sem->downCounter), &countValue );
+  if( sem == NULL ) return 0;
   
-  return (size_t) countValue;
+  return (size_t) ( __atomic_load_n( &(sem->state), __ATOMIC_ACQUIRE ) & COUNT_MASK );
 }
 
 void Sem_SetCount( Semaphore sem, size_t count )
 {
-  if( count <= sem->maxCount )
-  {
-    size_t currentCount = Sem_GetCount( sem );
-    
-    if( currentCount > count )
-    {
-      for( size_t i = count; i < currentCount; i++ )
-        Sem_Decrement( sem );
-    }
-    else if( currentCount < count )
-    {
-      for( size_t i = currentCount; i < count; i++ )
-        Sem_Increment( sem );
-    }
-  }
+  if( sem == NULL ) return;
+  
+  if( count > sem->maxCount ) return;
+  
+  uint64_t state = __atomic_load_n( &(sem->state), __ATOMIC_RELAXED );
+  while( !__atomic_compare_exchange_n( &(sem->state), &state, ( state & ~COUNT_MASK ) | count, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED ) );
+  
+  // Count may have moved in any direction: let all waiters check it again
+  if( ( state & ~COUNT_MASK ) != 0 ) Atomic_Wake( GetCountWord( sem ), true );
 }
-
-#endif // WIN32
@@ -31,10 +31,27 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include <stdbool.h>
 
 typedef struct _SemaphoreData SemaphoreData;    ///< Data structure to hold single semaphore data
 typedef SemaphoreData* Semaphore;               ///< Opaque type to semaphore data structure
 
+#define SEM_STORAGE_SIZE 16                     ///< Size (in bytes) of memory required by a single semaphore
+
+/// Caller provided memory (e.g. embedded on other structures) for holding a single semaphore
+typedef union _SemaphoreStorage
+{
+  uint8_t bytes[ SEM_STORAGE_SIZE ];            ///< Raw semaphore data
+  uint64_t alignment;                           ///< Forces proper alignment of semaphore data
+  void* pointerAlignment;                       ///< Forces proper alignment of semaphore data
+  struct { uint64_t count; uint32_t maxCount; } initialValues;   ///< Semaphore data layout set by SEM_STATIC_INIT()
+}
+SemaphoreStorage;
+
+/// Initializer for static storage of a semaphore (count should not exceed max) that doesn't require Sem_Init() call
+#define SEM_STATIC_INIT( count, max ) { .initialValues = { (uint64_t) (uint32_t) (count), (uint32_t) (max) } }
+#define SEM_FROM_STORAGE( storage ) ( (Semaphore) (storage) )   ///< Reference to semaphore held on given (initialized) storage pointer
+
                                                                             
 /// @brief Creates semaphore object/data structure and initializes it                                                
 /// @param[in] startCount starting value/count for newly created semaphore                                
@@ -46,6 +63,17 @@ Semaphore Sem_Create( size_t startCount, size_t maxCount );
 /// @param[in] sem reference to semaphore data structure
 void Sem_Discard( Semaphore sem );
 
+/// @brief Initializes semaphore on caller provided memory, without allocations
+/// @param[in] storage pointer to semaphore storage (should remain valid until Sem_Destroy())
+/// @param[in] startCount starting value/count for semaphore
+/// @param[in] maxCount maximum allowed value/count of semaphore
+/// @return reference to semaphore held on given storage (NULL on errors)
+Semaphore Sem_Init( SemaphoreStorage* storage, size_t startCount, size_t maxCount );
+
+/// @brief Releases resources of semaphore initialized with Sem_Init(), leaving its storage to the caller
+/// @param[in] sem reference to semaphore data structure
+void Sem_Destroy( Semaphore sem );
+
 /// @brief Increases internal count for given semaphore, blocking thread if maximum count is reached                             
 /// @param[in] sem reference to semaphore data structure
 void Sem_Increment( Semaphore sem );
@@ -54,12 +82,44 @@ void Sem_Increment( Semaphore sem );
 /// @param[in] sem reference to semaphore data structure
 void Sem_Decrement( Semaphore sem );
 
+/// @brief Increases internal count for given semaphore by multiple units at once, blocking thread until all of them fit below maximum count
+/// @param[in] sem reference to semaphore data structure
+/// @param[in] count number of units to add (ignored if 0 or above maximum count)
+void Sem_IncrementBy( Semaphore sem, size_t count );
+
+/// @brief Decreases internal count for given semaphore by multiple units at once, blocking thread until all of them are available
+/// @param[in] sem reference to semaphore data structure
+/// @param[in] count number of units to remove (ignored if 0 or above maximum count)
+void Sem_DecrementBy( Semaphore sem, size_t count );
+
+/// @brief Attempts to decrease internal count for given semaphore, returning immediately if zero count is reached                    
+/// @param[in] sem reference to semaphore data structure
+/// @return true if count got decreased, false otherwise
+bool Sem_TryDecrement( Semaphore sem );
+
+/// @brief Decreases internal count for given semaphore, blocking thread for a limited time if zero count is reached                    
+/// @param[in] sem reference to semaphore data structure
+/// @param[in] milliseconds maximum time (in milliseconds, measured with monotonic clock) for waiting (INFINITE to wait indefinitely)
+/// @return true if count got decreased, false on timeout
+bool Sem_DecrementTimed( Semaphore sem, unsigned int milliseconds );
+
+/// @brief Attempts to increase internal count for given semaphore, returning immediately if maximum count is reached                    
+/// @param[in] sem reference to semaphore data structure
+/// @return true if count got increased, false otherwise
+bool Sem_TryIncrement( Semaphore sem );
+
+/// @brief Increases internal count for given semaphore, blocking thread for a limited time if maximum count is reached                    
+/// @param[in] sem reference to semaphore data structure
+/// @param[in] milliseconds maximum time (in milliseconds, measured with monotonic clock) for waiting (INFINITE to wait indefinitely)
+/// @return true if count got increased, false on timeout
+bool Sem_IncrementTimed( Semaphore sem, unsigned int milliseconds );
+
 /// @brief Reads current internal count for given semaphore                              
 /// @param[in] sem reference to semaphore data structure
 /// @return current internal count 
 size_t Sem_GetCount( Semaphore sem );
 
-/// @brief Defines desired internal count for given semaphore                              
+/// @brief Defines desired internal count for given semaphore, at once (awakening blocked threads if needed)
 /// @param[in] sem reference to semaphore data structure
 /// @param[in] count desired internal count (should be between 0 and the maximum count) 
 void Sem_SetCount( Semaphore sem, size_t count );
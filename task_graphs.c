@@ -0,0 +1,197 @@
+//////////////////////////////////////////////////////////////////////////////////////
+//                                                                                  //
+//  Copyright (c) 2016-2025 Leonardo Consoni <leonardojc@protonmail.com>            //
+//                                                                                  //
+//  This file is part of Simple Multithreading.                                     //
+//                                                                                  //
+//  Simple Multithreading is free software: you can redistribute it and/or modify   //
+//  it under the terms of the GNU Lesser General Public License as published        //
+//  by the Free Software Foundation, either version 3 of the License, or            //
+//  (at your option) any later version.                                             //
+//                                                                                  //
+//  Simple Multithreading is distributed in the hope that it will be useful,        //
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of                  //
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                    //
+//  GNU Lesser General Public License for more details.                             //
+//                                                                                  //
+//  You should have received a copy of the GNU Lesser General Public License        //
+//  along with Simple Multithreading. If not, see <http://www.gnu.org/licenses/>.   //
+//                                                                                  //
+//////////////////////////////////////////////////////////////////////////////////////
+
+#include "task_graphs.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+static const size_t GRAPH_LENGTH_INCREMENT = 16;
+
+typedef struct _TaskNode
+{
+  AsyncFunction function;
+  void* args;
+  size_t* successors;
+  size_t successorsCount, successorsLength;
+  size_t predecessorsCount;
+  volatile size_t pendingCount;
+  TaskGraph graph;
+}
+TaskNode;
+
+struct _TaskGraphData
+{
+  TaskScheduler scheduler;
+  TaskNode* nodes;
+  size_t nodesCount, nodesLength;
+  bool isChecked, isAcyclic;
+  TaskCounter runningCount;
+};
+
+
+TaskGraph TaskGraph_Create( TaskScheduler scheduler )
+{
+  TaskGraph graph = (TaskGraph) malloc( sizeof(TaskGraphData) );
+  
+  graph->scheduler = ( scheduler != NULL ) ? scheduler : TaskScheduler_GetDefault();
+  graph->nodesLength = GRAPH_LENGTH_INCREMENT;
+  graph->nodes = (TaskNode*) malloc( graph->nodesLength * sizeof(TaskNode) );
+  graph->nodesCount = 0;
+  graph->isChecked = graph->isAcyclic = true;
+  graph->runningCount = 0;
+  
+  return graph;
+}
+
+void TaskGraph_Discard( TaskGraph graph )
+{
+  if( graph == NULL ) return;
+  
+  for( size_t i = 0; i < graph->nodesCount; i++ )
+    free( graph->nodes[ i ].successors );
+  free( graph->nodes );
+  
+  free( graph );
+}
+
+size_t TaskGraph_AddNode( TaskGraph graph, AsyncFunction function, void* args )
+{
+  if( graph == NULL || function == NULL ) return TASK_GRAPH_INVALID_NODE;
+  
+  if( graph->nodesCount == graph->nodesLength )
+  {
+    graph->nodesLength += GRAPH_LENGTH_INCREMENT;
+    graph->nodes = (TaskNode*) realloc( graph->nodes, graph->nodesLength * sizeof(TaskNode) );
+  }
+  
+  TaskNode* node = &(graph->nodes[ graph->nodesCount ]);
+  node->function = function;
+  node->args = args;
+  node->successors = NULL;
+  node->successorsCount = node->successorsLength = 0;
+  node->predecessorsCount = 0;
+  node->pendingCount = 0;
+  
+  return graph->nodesCount++;
+}
+
+bool TaskGraph_AddEdge( TaskGraph graph, size_t predecessor, size_t successor )
+{
+  if( graph == NULL ) return false;
+  if( predecessor >= graph->nodesCount || successor >= graph->nodesCount ) return false;
+  
+  TaskNode* node = &(graph->nodes[ predecessor ]);
+  if( node->successorsCount == node->successorsLength )
+  {
+    node->successorsLength += GRAPH_LENGTH_INCREMENT;
+    node->successors = (size_t*) realloc( node->successors, node->successorsLength * sizeof(size_t) );
+  }
+  node->successors[ node->successorsCount++ ] = successor;
+  graph->nodes[ successor ].predecessorsCount++;
+  
+  graph->isChecked = false;
+  
+  return true;
+}
+
+// Topological sort (Kahn's algorithm) for checking if all nodes are reachable from dependency-free ones
+static bool CheckAcyclic( TaskGraph graph )
+{
+  size_t* pendingCounts = (size_t*) malloc( graph->nodesCount * sizeof(size_t) );
+  size_t* readyNodes = (size_t*) malloc( graph->nodesCount * sizeof(size_t) );
+  size_t readyCount = 0, visitedCount = 0;
+  
+  for( size_t i = 0; i < graph->nodesCount; i++ )
+  {
+    pendingCounts[ i ] = graph->nodes[ i ].predecessorsCount;
+    if( pendingCounts[ i ] == 0 ) readyNodes[ readyCount++ ] = i;
+  }
+  
+  while( readyCount > 0 )
+  {
+    TaskNode* node = &(graph->nodes[ readyNodes[ --readyCount ] ]);
+    visitedCount++;
+    for( size_t i = 0; i < node->successorsCount; i++ )
+    {
+      if( --pendingCounts[ node->successors[ i ] ] == 0 ) readyNodes[ readyCount++ ] = node->successors[ i ];
+    }
+  }
+  
+  free( pendingCounts );
+  free( readyNodes );
+  
+  return ( visitedCount == graph->nodesCount );
+}
+
+// Runs node task and releases successors whose dependencies are all finished
+static void* RunNode( void* args )
+{
+  TaskNode* node = (TaskNode*) args;
+  TaskGraph graph = node->graph;
+  
+  node->function( node->args );
+  
+  for( size_t i = 0; i < node->successorsCount; i++ )
+  {
+    TaskNode* successor = &(graph->nodes[ node->successors[ i ] ]);
+    if( __atomic_sub_fetch( &(successor->pendingCount), 1, __ATOMIC_ACQ_REL ) == 0 )
+      TaskScheduler_Spawn( graph->scheduler, RunNode, (void*) successor, &(graph->runningCount) );
+  }
+  
+  return NULL;
+}
+
+bool TaskGraph_Run( TaskGraph graph )
+{
+  if( graph == NULL ) return false;
+  
+  // Structure is only validated again after changes, so repeated runs do not allocate
+  if( !graph->isChecked )
+  {
+    graph->isAcyclic = CheckAcyclic( graph );
+    graph->isChecked = true;
+  }
+  if( !graph->isAcyclic ) return false;
+  
+  for( size_t i = 0; i < graph->nodesCount; i++ )
+  {
+    graph->nodes[ i ].graph = graph;
+    __atomic_store_n( &(graph->nodes[ i ].pendingCount), graph->nodes[ i ].predecessorsCount, __ATOMIC_RELAXED );
+  }
+  
+  graph->runningCount = 0;
+  for( size_t i = 0; i < graph->nodesCount; i++ )
+  {
+    if( graph->nodes[ i ].predecessorsCount == 0 )
+      TaskScheduler_Spawn( graph->scheduler, RunNode, (void*) &(graph->nodes[ i ]), &(graph->runningCount) );
+  }
+  TaskScheduler_Join( graph->scheduler, &(graph->runningCount) );
+  
+  return true;
+}
+
+size_t TaskGraph_GetNodesCount( TaskGraph graph )
+{
+  if( graph == NULL ) return 0;
+  
+  return graph->nodesCount;
+}
@@ -0,0 +1,77 @@
+//////////////////////////////////////////////////////////////////////////////////////
+//                                                                                  //
+//  Copyright (c) 2016-2025 Leonardo Consoni <leonardojc@protonmail.com>             //
+//                                                                                  //
+//  This file is part of Simple Multithreading.                                     //
+//                                                                                  //
+//  Simple Multithreading is free software: you can redistribute it and/or modify   //
+//  it under the terms of the GNU Lesser General Public License as published        //
+//  by the Free Software Foundation, either version 3 of the License, or            //
+//  (at your option) any later version.                                             //
+//                                                                                  //
+//  Simple Multithreading is distributed in the hope that it will be useful,        //
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of                  //
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                    //
+//  GNU Lesser General Public License for more details.                             //
+//                                                                                  //
+//  You should have received a copy of the GNU Lesser General Public License        //
+//  along with Simple Multithreading. If not, see <http://www.gnu.org/licenses/>.   //
+//                                                                                  //
+//////////////////////////////////////////////////////////////////////////////////////
+
+
+/// @file task_graphs.h
+/// @brief Reusable task graphs (DAGs) with dependency counting.
+///
+/// Directed acyclic graphs of tasks with precedence edges, run repeatedly on a task scheduler:
+/// each task is released as soon as all its predecessors finish, through atomic dependency counters
+
+#ifndef TASK_GRAPHS_H
+#define TASK_GRAPHS_H
+
+#include "task_schedulers.h"
+
+#include <stdbool.h>
+
+#define TASK_GRAPH_INVALID_NODE ( (size_t) -1 )     ///< Node index returned on errors
+
+/// Structure holding single task graph data
+typedef struct _TaskGraphData TaskGraphData;
+/// Opaque reference to task graph data structure
+typedef TaskGraphData* TaskGraph;
+
+                                                                            
+/// @brief Creates empty task graph data structure                                               
+/// @param[in] scheduler reference to scheduler that will run graph tasks (NULL for default scheduler)
+/// @return reference to newly created task graph
+TaskGraph TaskGraph_Create( TaskScheduler scheduler );
+
+/// @brief Deallocates given task graph data structure (should not be running)
+/// @param[in] graph reference to task graph
+void TaskGraph_Discard( TaskGraph graph );
+
+/// @brief Adds new task node to given graph (should not be running)
+/// @param[in] graph reference to task graph
+/// @param[in] function pointer to the function run for the node on each graph execution (its return value is ignored)
+/// @param[in] args opaque pointer to struct that will be passed as the function argument
+/// @return index of the new node (TASK_GRAPH_INVALID_NODE on errors)
+size_t TaskGraph_AddNode( TaskGraph graph, AsyncFunction function, void* args );
+
+/// @brief Adds precedence edge between nodes of given graph (should not be running)
+/// @param[in] graph reference to task graph
+/// @param[in] predecessor index of the node that should finish first
+/// @param[in] successor index of the node that should only start after predecessor finishes
+/// @return true on successful insertion, false on invalid indexes
+bool TaskGraph_AddEdge( TaskGraph graph, size_t predecessor, size_t successor );
+
+/// @brief Runs all tasks of given graph respecting precedences, returning after all of them finish (calling thread also runs tasks)
+/// @param[in] graph reference to task graph
+/// @return true on successful execution, false if graph has cycles
+bool TaskGraph_Run( TaskGraph graph );
+
+/// @brief Gets given task graph current number of nodes
+/// @param[in] graph reference to task graph
+/// @return current number of nodes
+size_t TaskGraph_GetNodesCount( TaskGraph graph );
+
+#endif // TASK_GRAPHS_H
@@ -0,0 +1,415 @@
+//////////////////////////////////////////////////////////////////////////////////////
+//                                                                                  //
+//  Copyright (c) 2016-2025 Leonardo Consoni <leonardojc@protonmail.com>            //
+//                                                                                  //
+//  This file is part of Simple Multithreading.                                     //
+//                                                                                  //
+//  Simple Multithreading is free software: you can redistribute it and/or modify   //
+//  it under the terms of the GNU Lesser General Public License as published        //
+//  by the Free Software Foundation, either version 3 of the License, or            //
+//  (at your option) any later version.                                             //
+//                                                                                  //
+//  Simple Multithreading is distributed in the hope that it will be useful,        //
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of                  //
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                    //
+//  GNU Lesser General Public License for more details.                             //
+//                                                                                  //
+//  You should have received a copy of the GNU Lesser General Public License        //
+//  along with Simple Multithreading. If not, see <http://www.gnu.org/licenses/>.   //
+//                                                                                  //
+//////////////////////////////////////////////////////////////////////////////////////
+
+#include "thread_atomics.h"
+#include "thread_locks.h"
+
+#include "task_schedulers.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+// Fixed capacity of worker deques (tasks spawned on a full deque are run immediately by the spawning thread)
+static const int64_t DEQUE_LENGTH = 4096;
+// Number of unsuccessful task searches before an idle thread blocks/yields
+static const size_t IDLE_SPINS_COUNT = 64;
+static const size_t INJECTION_LENGTH_INCREMENT = 64;
+
+typedef struct _Task
+{
+  AsyncFunction function;
+  void* args;
+  TaskCounter* counter;
+}
+Task;
+
+// Chase-Lev deque: owner pushes and pops at bottom, thieves take from top
+typedef struct _TaskDeque
+{
+  volatile int64_t top;
+  uint8_t topPadding[ ATOMIC_CACHE_LINE_SIZE - sizeof(int64_t) ];
+  volatile int64_t bottom;
+  uint8_t bottomPadding[ ATOMIC_CACHE_LINE_SIZE - sizeof(int64_t) ];
+  Task* tasks;
+  uint8_t tasksPadding[ ATOMIC_CACHE_LINE_SIZE - sizeof(Task*) ];
+}
+TaskDeque;
+
+typedef struct _Worker
+{
+  TaskDeque deque;
+  TaskScheduler scheduler;
+  Thread thread;
+  uint32_t randomSeed;
+}
+Worker;
+
+struct _TaskSchedulerData
+{
+  Worker* workers;
+  size_t workersCount;
+  TLock injectionLock;
+  Task* injectedTasks;
+  size_t injectionFirst, injectionLength;
+  volatile size_t injectedCount;
+  volatile uint32_t wakeEpoch;
+  volatile size_t sleepersCount;
+  volatile size_t joinersCount;
+  volatile bool isRunning;
+};
+
+static THREAD_LOCAL Worker* currentWorker = NULL;
+
+
+// Task fields are read concurrently by thieves, so they are copied with (relaxed) atomic operations
+
+static inline void WriteTask( Task* slot, Task task )
+{
+  __atomic_store_n( &(slot->function), task.function, __ATOMIC_RELAXED );
+  __atomic_store_n( &(slot->args), task.args, __ATOMIC_RELAXED );
+  __atomic_store_n( &(slot->counter), task.counter, __ATOMIC_RELAXED );
+}
+
+static inline Task ReadTask( Task* slot )
+{
+  Task task = { __atomic_load_n( &(slot->function), __ATOMIC_RELAXED ), 
+                __atomic_load_n( &(slot->args), __ATOMIC_RELAXED ),
+                __atomic_load_n( &(slot->counter), __ATOMIC_RELAXED ) };
+  return task;
+}
+
+static bool PushTask( TaskDeque* deque, Task task )
+{
+  int64_t bottom = __atomic_load_n( &(deque->bottom), __ATOMIC_RELAXED );
+  int64_t top = __atomic_load_n( &(deque->top), __ATOMIC_ACQUIRE );
+  if( bottom - top >= DEQUE_LENGTH ) return false;
+  
+  WriteTask( &(deque->tasks[ bottom & ( DEQUE_LENGTH - 1 ) ]), task );
+  __atomic_store_n( &(deque->bottom), bottom + 1, __ATOMIC_RELEASE );
+  
+  return true;
+}
+
+static bool PopTask( TaskDeque* deque, Task* task )
+{
+  int64_t bottom = __atomic_load_n( &(deque->bottom), __ATOMIC_RELAXED ) - 1;
+  __atomic_store_n( &(deque->bottom), bottom, __ATOMIC_RELAXED );
+  __atomic_thread_fence( __ATOMIC_SEQ_CST );
+  int64_t top = __atomic_load_n( &(deque->top), __ATOMIC_RELAXED );
+  
+  bool isFound = false;
+  if( top <= bottom )
+  {
+    *task = ReadTask( &(deque->tasks[ bottom & ( DEQUE_LENGTH - 1 ) ]) );
+    if( top < bottom ) return true;
+    // Last item: race against thieves for it
+    isFound = __atomic_compare_exchange_n( &(deque->top), &top, top + 1, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED );
+  }
+  __atomic_store_n( &(deque->bottom), bottom + 1, __ATOMIC_RELAXED );
+  
+  return isFound;
+}
+
+static bool StealTask( TaskDeque* deque, Task* task )
+{
+  int64_t top = __atomic_load_n( &(deque->top), __ATOMIC_ACQUIRE );
+  __atomic_thread_fence( __ATOMIC_SEQ_CST );
+  int64_t bottom = __atomic_load_n( &(deque->bottom), __ATOMIC_ACQUIRE );
+  if( top >= bottom ) return false;
+  
+  *task = ReadTask( &(deque->tasks[ top & ( DEQUE_LENGTH - 1 ) ]) );
+  return __atomic_compare_exchange_n( &(deque->top), &top, top + 1, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED );
+}
+
+// Tasks spawned from outside worker threads go to a shared (locked) injection queue
+static void InjectTask( TaskScheduler scheduler, Task task )
+{
+  TLock_Acquire( scheduler->injectionLock );
+  size_t count = __atomic_load_n( &(scheduler->injectedCount), __ATOMIC_RELAXED );
+  if( count == scheduler->injectionLength )
+  {
+    size_t newLength = scheduler->injectionLength + INJECTION_LENGTH_INCREMENT;
+    Task* newTasks = (Task*) malloc( newLength * sizeof(Task) );
+    for( size_t i = 0; i < count; i++ )
+      newTasks[ i ] = scheduler->injectedTasks[ ( scheduler->injectionFirst + i ) % scheduler->injectionLength ];
+    free( scheduler->injectedTasks );
+    scheduler->injectedTasks = newTasks;
+    scheduler->injectionLength = newLength;
+    scheduler->injectionFirst = 0;
+  }
+  scheduler->injectedTasks[ ( scheduler->injectionFirst + count ) % scheduler->injectionLength ] = task;
+  __atomic_store_n( &(scheduler->injectedCount), count + 1, __ATOMIC_SEQ_CST );
+  TLock_Release( scheduler->injectionLock );
+}
+
+static bool TakeInjectedTask( TaskScheduler scheduler, Task* task )
+{
+  if( __atomic_load_n( &(scheduler->injectedCount), __ATOMIC_ACQUIRE ) == 0 ) return false;
+  
+  bool isFound = false;
+  TLock_Acquire( scheduler->injectionLock );
+  size_t count = __atomic_load_n( &(scheduler->injectedCount), __ATOMIC_RELAXED );
+  if( count > 0 )
+  {
+    *task = scheduler->injectedTasks[ scheduler->injectionFirst ];
+    scheduler->injectionFirst = ( scheduler->injectionFirst + 1 ) % scheduler->injectionLength;
+    __atomic_store_n( &(scheduler->injectedCount), count - 1, __ATOMIC_RELAXED );
+    isFound = true;
+  }
+  TLock_Release( scheduler->injectionLock );
+  
+  return isFound;
+}
+
+// Looks for a runnable task on own deque, then on injection queue, then on other workers deques
+static bool FindTask( TaskScheduler scheduler, Worker* self, Task* task )
+{
+  static THREAD_LOCAL uint32_t externalSeed = 1;
+  
+  if( self != NULL && PopTask( &(self->deque), task ) ) return true;
+  
+  if( TakeInjectedTask( scheduler, task ) ) return true;
+  
+  uint32_t* seed = ( self != NULL ) ? &(self->randomSeed) : &externalSeed;
+  *seed ^= *seed << 13; *seed ^= *seed >> 17; *seed ^= *seed << 5;
+  size_t firstVictim = (size_t) *seed % scheduler->workersCount;
+  for( size_t i = 0; i < scheduler->workersCount; i++ )
+  {
+    Worker* victim = &(scheduler->workers[ ( firstVictim + i ) % scheduler->workersCount ]);
+    if( victim != self && StealTask( &(victim->deque), task ) ) return true;
+  }
+  
+  return false;
+}
+
+static inline void RunTask( TaskScheduler scheduler, Task task )
+{
+  task.function( task.args );
+  // Last task of a counter awakes parked joiners (the counter itself may be gone right after the decrement)
+  if( task.counter != NULL && __atomic_sub_fetch( task.counter, 1, __ATOMIC_SEQ_CST ) == 0 )
+  {
+    if( __atomic_load_n( &(scheduler->joinersCount), __ATOMIC_SEQ_CST ) > 0 )
+    {
+      __atomic_fetch_add( &(scheduler->wakeEpoch), 1, __ATOMIC_SEQ_CST );
+      Atomic_Wake( &(scheduler->wakeEpoch), true );
+    }
+  }
+}
+
+// Awakes one sleeping worker, if any (costs only a load when all workers are busy)
+static inline void NotifyIdleWorker( TaskScheduler scheduler )
+{
+  __atomic_thread_fence( __ATOMIC_SEQ_CST );
+  if( __atomic_load_n( &(scheduler->sleepersCount), __ATOMIC_RELAXED ) > 0 )
+  {
+    __atomic_fetch_add( &(scheduler->wakeEpoch), 1, __ATOMIC_SEQ_CST );
+    Atomic_Wake( &(scheduler->wakeEpoch), false );
+  }
+}
+
+static void* RunWorker( void* args )
+{
+  Worker* self = (Worker*) args;
+  TaskScheduler scheduler = self->scheduler;
+  Task task;
+  
+  currentWorker = self;
+  
+  while( true )
+  {
+    bool isFound = false;
+    for( size_t i = 0; i < IDLE_SPINS_COUNT && !isFound; i++ )
+    {
+      if( !(isFound = FindTask( scheduler, self, &task )) ) Atomic_Pause();
+    }
+    
+    if( !isFound )
+    {
+      // Register as sleeper before the last check, so that concurrent spawns do not miss us
+      __atomic_fetch_add( &(scheduler->sleepersCount), 1, __ATOMIC_SEQ_CST );
+      uint32_t epoch = __atomic_load_n( &(scheduler->wakeEpoch), __ATOMIC_SEQ_CST );
+      isFound = FindTask( scheduler, self, &task );
+      if( !isFound && __atomic_load_n( &(scheduler->isRunning), __ATOMIC_SEQ_CST ) )
+        Atomic_Wait( &(scheduler->wakeEpoch), epoch, ATOMIC_TIME_INFINITE );
+      __atomic_fetch_sub( &(scheduler->sleepersCount), 1, __ATOMIC_SEQ_CST );
+      
+      if( !isFound && !__atomic_load_n( &(scheduler->isRunning), __ATOMIC_SEQ_CST ) ) break;
+    }
+    
+    if( isFound ) RunTask( scheduler, task );
+  }
+  
+  currentWorker = NULL;
+  
+  return NULL;
+}
+
+TaskScheduler TaskScheduler_Create( size_t workersCount )
+{
+  if( workersCount == 0 ) return NULL;
+  
+  TaskScheduler scheduler = (TaskScheduler) malloc( sizeof(TaskSchedulerData) );
+  
+  scheduler->injectionLock = TLock_Create();
+  scheduler->injectionLength = INJECTION_LENGTH_INCREMENT;
+  scheduler->injectedTasks = (Task*) malloc( scheduler->injectionLength * sizeof(Task) );
+  scheduler->injectionFirst = scheduler->injectedCount = 0;
+  scheduler->wakeEpoch = 0;
+  scheduler->sleepersCount = 0;
+  scheduler->joinersCount = 0;
+  scheduler->isRunning = true;
+  
+  scheduler->workers = (Worker*) calloc( workersCount, sizeof(Worker) );
+  scheduler->workersCount = workersCount;
+  for( size_t i = 0; i < workersCount; i++ )
+  {
+    scheduler->workers[ i ].deque.top = scheduler->workers[ i ].deque.bottom = 0;
+    scheduler->workers[ i ].deque.tasks = (Task*) calloc( DEQUE_LENGTH, sizeof(Task) );
+    scheduler->workers[ i ].scheduler = scheduler;
+    scheduler->workers[ i ].randomSeed = (uint32_t) ( 2 * i + 1 );
+  }
+  
+  // Workers steal from each other, so all deques should exist before any worker starts
+  size_t startedCount = 0;
+  for( ; startedCount < workersCount; startedCount++ )
+  {
+    Worker* worker = &(scheduler->workers[ startedCount ]);
+    worker->thread = Thread_Start( RunWorker, (void*) worker, THREAD_JOINABLE );
+    if( worker->thread == THREAD_INVALID_HANDLE ) break;
+  }
+  
+  if( startedCount < workersCount )
+  {
+    scheduler->workersCount = startedCount;
+    TaskScheduler_Discard( scheduler );
+    return NULL;
+  }
+  
+  return scheduler;
+}
+
+void TaskScheduler_Discard( TaskScheduler scheduler )
+{
+  if( scheduler == NULL ) return;
+  
+  __atomic_store_n( &(scheduler->isRunning), false, __ATOMIC_SEQ_CST );
+  __atomic_fetch_add( &(scheduler->wakeEpoch), 1, __ATOMIC_SEQ_CST );
+  Atomic_Wake( &(scheduler->wakeEpoch), true );
+  
+  for( size_t i = 0; i < scheduler->workersCount; i++ )
+    Thread_WaitExit( scheduler->workers[ i ].thread, INFINITE );
+  
+  for( size_t i = 0; i < scheduler->workersCount; i++ )
+    free( scheduler->workers[ i ].deque.tasks );
+  free( scheduler->workers );
+  
+  free( scheduler->injectedTasks );
+  TLock_Discard( scheduler->injectionLock );
+  
+  free( scheduler );
+}
+
+bool TaskScheduler_Spawn( TaskScheduler scheduler, AsyncFunction function, void* args, TaskCounter* counter )
+{
+  if( scheduler == NULL || function == NULL ) return false;
+  
+  Task task = { function, args, counter };
+  if( counter != NULL ) __atomic_fetch_add( counter, 1, __ATOMIC_RELAXED );
+  
+  if( currentWorker != NULL && currentWorker->scheduler == scheduler )
+  {
+    if( !PushTask( &(currentWorker->deque), task ) )
+    {
+      RunTask( scheduler, task );
+      return true;
+    }
+  }
+  else
+  {
+    InjectTask( scheduler, task );
+  }
+  
+  NotifyIdleWorker( scheduler );
+  
+  return true;
+}
+
+void TaskScheduler_Join( TaskScheduler scheduler, TaskCounter* counter )
+{
+  if( scheduler == NULL || counter == NULL ) return;
+  
+  Worker* self = ( currentWorker != NULL && currentWorker->scheduler == scheduler ) ? currentWorker : NULL;
+  Task task;
+  
+  size_t idleCount = 0;
+  while( __atomic_load_n( counter, __ATOMIC_ACQUIRE ) > 0 )
+  {
+    if( FindTask( scheduler, self, &task ) ) 
+    {
+      RunTask( scheduler, task );
+      idleCount = 0;
+    }
+    else if( ++idleCount < IDLE_SPINS_COUNT ) Atomic_Pause();
+    else
+    {
+      // Park like idle workers (awaken by spawns too), also registered as joiner so that the last task of the counter awakes us
+      __atomic_fetch_add( &(scheduler->sleepersCount), 1, __ATOMIC_SEQ_CST );
+      __atomic_fetch_add( &(scheduler->joinersCount), 1, __ATOMIC_SEQ_CST );
+      uint32_t epoch = __atomic_load_n( &(scheduler->wakeEpoch), __ATOMIC_SEQ_CST );
+      bool isFound = FindTask( scheduler, self, &task );
+      bool isParked = ( !isFound && __atomic_load_n( counter, __ATOMIC_SEQ_CST ) > 0 );
+      if( isParked ) Atomic_Wait( &(scheduler->wakeEpoch), epoch, ATOMIC_TIME_INFINITE );
+      __atomic_fetch_sub( &(scheduler->joinersCount), 1, __ATOMIC_SEQ_CST );
+      __atomic_fetch_sub( &(scheduler->sleepersCount), 1, __ATOMIC_SEQ_CST );
+      
+      if( isFound ) RunTask( scheduler, task );
+      // A single wake meant for a spawned task may have been taken by us: pass it to a worker if we are leaving
+      else if( isParked && __atomic_load_n( counter, __ATOMIC_ACQUIRE ) == 0 ) NotifyIdleWorker( scheduler );
+      idleCount = 0;
+    }
+  }
+}
+
+size_t TaskScheduler_GetWorkersCount( TaskScheduler scheduler )
+{
+  if( scheduler == NULL ) return 0;
+  
+  return scheduler->workersCount;
+}
+
+TaskScheduler TaskScheduler_GetDefault()
+{
+  static TaskScheduler defaultScheduler = NULL;
+  
+  TaskScheduler scheduler = __atomic_load_n( &defaultScheduler, __ATOMIC_ACQUIRE );
+  if( scheduler != NULL ) return scheduler;
+  
+  // Calling threads also run tasks while joining, so one processor is left for them
+  size_t cpusCount = Thread_GetTopology( NULL, 0 );
+  TaskScheduler newScheduler = TaskScheduler_Create( ( cpusCount > 2 ) ? cpusCount - 1 : 1 );
+  if( !__atomic_compare_exchange_n( &defaultScheduler, &scheduler, newScheduler, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE ) )
+  {
+    TaskScheduler_Discard( newScheduler );
+    return scheduler;
+  }
+  
+  return newScheduler;
+}
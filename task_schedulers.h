@@ -0,0 +1,77 @@
+//////////////////////////////////////////////////////////////////////////////////////
+//                                                                                  //
+//  Copyright (c) 2016-2025 Leonardo Consoni <leonardojc@protonmail.com>             //
+//                                                                                  //
+//  This file is part of Simple Multithreading.                                     //
+//                                                                                  //
+//  Simple Multithreading is free software: you can redistribute it and/or modify   //
+//  it under the terms of the GNU Lesser General Public License as published        //
+//  by the Free Software Foundation, either version 3 of the License, or            //
+//  (at your option) any later version.                                             //
+//                                                                                  //
+//  Simple Multithreading is distributed in the hope that it will be useful,        //
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of                  //
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                    //
+//  GNU Lesser General Public License for more details.                             //
+//                                                                                  //
+//  You should have received a copy of the GNU Lesser General Public License        //
+//  along with Simple Multithreading. If not, see <http://www.gnu.org/licenses/>.   //
+//                                                                                  //
+//////////////////////////////////////////////////////////////////////////////////////
+
+
+/// @file task_schedulers.h
+/// @brief Work-stealing scheduler for fork/join parallel tasks.
+///
+/// Persistent worker threads that run spawned tasks from per-worker lock-free deques:
+/// each worker pushes and pops its own tasks locally, and idle workers steal from the
+/// opposite end of other workers deques, so that recursively spawned tasks never take a global lock
+
+#ifndef TASK_SCHEDULERS_H
+#define TASK_SCHEDULERS_H
+
+#include "threads.h"
+
+#include <stdbool.h>
+
+/// Structure holding single work-stealing scheduler data
+typedef struct _TaskSchedulerData TaskSchedulerData;
+/// Opaque reference to work-stealing scheduler data structure
+typedef TaskSchedulerData* TaskScheduler;
+
+/// Number of unfinished tasks of a fork/join group (should be initialized to 0 and only modified by scheduler calls)
+typedef volatile size_t TaskCounter;
+
+                                                                            
+/// @brief Creates work-stealing scheduler data structure and starts its worker threads                                               
+/// @param[in] workersCount number of persistent worker threads                                   
+/// @return reference to newly created scheduler (NULL on errors)
+TaskScheduler TaskScheduler_Create( size_t workersCount );
+
+/// @brief Stops worker threads (after all spawned tasks are run) and deallocates given scheduler data
+/// @param[in] scheduler reference to scheduler
+void TaskScheduler_Discard( TaskScheduler scheduler );
+
+/// @brief Spawns task to be run asynchronously by one of the scheduler workers
+/// @param[in] scheduler reference to scheduler
+/// @param[in] function pointer to the function that will run as a task (its return value is ignored)
+/// @param[in] args opaque pointer to struct that will be passed as the function argument
+/// @param[in,out] counter pointer to fork/join group counter, incremented now and decremented when the task finishes (NULL for none)
+/// @return true on successful spawning, false otherwise
+bool TaskScheduler_Spawn( TaskScheduler scheduler, AsyncFunction function, void* args, TaskCounter* counter );
+
+/// @brief Waits for all tasks of given fork/join group to finish, running pending tasks on calling thread meanwhile (blocking while there are none)
+/// @param[in] scheduler reference to scheduler
+/// @param[in] counter pointer to fork/join group counter
+void TaskScheduler_Join( TaskScheduler scheduler, TaskCounter* counter );
+
+/// @brief Gets number of worker threads of given scheduler
+/// @param[in] scheduler reference to scheduler
+/// @return number of worker threads
+size_t TaskScheduler_GetWorkersCount( TaskScheduler scheduler );
+
+/// @brief Gets shared process-wide scheduler, created on first call with one worker less than the online processors (at least one)
+/// @return reference to default scheduler (should not be discarded)
+TaskScheduler TaskScheduler_GetDefault();
+
+#endif // TASK_SCHEDULERS_H
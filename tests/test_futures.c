@@ -0,0 +1,90 @@
+//////////////////////////////////////////////////////////////////////////////////////
+//                                                                                  //
+//  Copyright (c) 2016-2025 Leonardo Consoni <leonardojc@protonmail.com>            //
+//                                                                                  //
+//  This file is part of Simple Multithreading.                                     //
+//                                                                                  //
+//  Simple Multithreading is free software: you can redistribute it and/or modify   //
+//  it under the terms of the GNU Lesser General Public License as published        //
+//  by the Free Software Foundation, either version 3 of the License, or            //
+//  (at your option) any later version.                                             //
+//                                                                                  //
+//  Simple Multithreading is distributed in the hope that it will be useful,        //
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of                  //
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                    //
+//  GNU Lesser General Public License for more details.                             //
+//                                                                                  //
+//  You should have received a copy of the GNU Lesser General Public License        //
+//  along with Simple Multithreading. If not, see <http://www.gnu.org/licenses/>.   //
+//                                                                                  //
+//////////////////////////////////////////////////////////////////////////////////////
+
+#include "thread_futures.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#define RACE_ITERATIONS_NUMBER 2000
+#define CONTINUATIONS_NUMBER 8
+
+static void* Increment( void* value )
+{
+  return (void*) ( (uintptr_t) value + 1 );
+}
+
+static void* CompletePromise( void* args )
+{
+  Future_Complete( (Future) args, (void*) (uintptr_t) 1 );
+  
+  return NULL;
+}
+
+// Completer keeps running continuations while the waiter discards the only promise reference
+static bool TestCompletionRaceWithDiscard()
+{
+  for( size_t iteration = 0; iteration < RACE_ITERATIONS_NUMBER; iteration++ )
+  {
+    Future promise = Future_Create();
+    for( size_t continuationIndex = 0; continuationIndex < CONTINUATIONS_NUMBER; continuationIndex++ )
+      Future_Discard( Future_Then( promise, Increment ) );
+    
+    Thread completer = Thread_Start( CompletePromise, (void*) promise, THREAD_JOINABLE );
+    if( completer == THREAD_INVALID_HANDLE ) return false;
+    
+    bool isDone = Future_Wait( promise, INFINITE );
+    bool isResultValid = ( (uintptr_t) Future_GetResult( promise ) == 1 );
+    Future_Discard( promise );
+    Thread_WaitExit( completer, INFINITE );
+    
+    if( !isDone || !isResultValid ) return false;
+  }
+  
+  return true;
+}
+
+static bool TestStartedFutures()
+{
+  Future futures[ CONTINUATIONS_NUMBER ];
+  for( size_t futureIndex = 0; futureIndex < CONTINUATIONS_NUMBER; futureIndex++ )
+    futures[ futureIndex ] = Future_Start( Increment, (void*) futureIndex );
+  
+  bool isSuccess = Future_WaitAll( futures, CONTINUATIONS_NUMBER, INFINITE );
+  for( size_t futureIndex = 0; futureIndex < CONTINUATIONS_NUMBER; futureIndex++ )
+  {
+    if( (uintptr_t) Future_GetResult( futures[ futureIndex ] ) != futureIndex + 1 ) isSuccess = false;
+    Future_Discard( futures[ futureIndex ] );
+  }
+  
+  return isSuccess;
+}
+
+int main()
+{
+  bool isSuccess = true;
+  
+  if( !TestCompletionRaceWithDiscard() ) { fprintf( stderr, "completion race with discard failed\n" ); isSuccess = false; }
+  if( !TestStartedFutures() ) { fprintf( stderr, "started futures failed\n" ); isSuccess = false; }
+  
+  return isSuccess ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,254 @@
+//////////////////////////////////////////////////////////////////////////////////////
+//                                                                                  //
+//  Copyright (c) 2016-2025 Leonardo Consoni <leonardojc@protonmail.com>            //
+//                                                                                  //
+//  This file is part of Simple Multithreading.                                     //
+//                                                                                  //
+//  Simple Multithreading is free software: you can redistribute it and/or modify   //
+//  it under the terms of the GNU Lesser General Public License as published        //
+//  by the Free Software Foundation, either version 3 of the License, or            //
+//  (at your option) any later version.                                             //
+//                                                                                  //
+//  Simple Multithreading is distributed in the hope that it will be useful,        //
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of                  //
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                    //
+//  GNU Lesser General Public License for more details.                             //
+//                                                                                  //
+//  You should have received a copy of the GNU Lesser General Public License        //
+//  along with Simple Multithreading. If not, see <http://www.gnu.org/licenses/>.   //
+//                                                                                  //
+//////////////////////////////////////////////////////////////////////////////////////
+
+#include "thread_atomics.h"
+#include "thread_safe_queues.h"
+#include "threads.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifndef WIN32
+#include <sys/resource.h>
+#endif
+
+#define ITEMS_NUMBER 200000
+#define SMALL_QUEUE_LENGTH 8
+#define SET_ITERATIONS_NUMBER 2000
+#define LARGE_ITEM_SIZE ( 1024 * 1024 )
+#define MAX_LARGE_ITEMS_NUMBER 4096
+
+// Multi-word items, for detecting slots overwritten while being read
+typedef struct _TestItem
+{
+  size_t values[ 5 ];
+}
+TestItem;
+
+typedef struct _TestQueue
+{
+  TSQueue queue;
+  volatile bool isDone;
+}
+TestQueue;
+
+static void SetItem( TestItem* item, size_t value )
+{
+  for( size_t i = 0; i < 5; i++ ) item->values[ i ] = value;
+}
+
+static bool IsItemValid( const TestItem* item )
+{
+  for( size_t i = 1; i < 5; i++ )
+    if( item->values[ i ] != item->values[ 0 ] ) return false;
+  return true;
+}
+
+static void* ProduceOverwriting( void* args )
+{
+  TestQueue* test = (TestQueue*) args;
+  TestItem item;
+  for( size_t value = 1; value <= ITEMS_NUMBER; value++ )
+  {
+    SetItem( &item, value );
+    TSQ_Enqueue( test->queue, &item, TSQUEUE_NOWAIT );
+  }
+  __atomic_store_n( &(test->isDone), true, __ATOMIC_RELEASE );
+  
+  return NULL;
+}
+
+static void* ProduceWaiting( void* args )
+{
+  TestQueue* test = (TestQueue*) args;
+  TestItem item;
+  for( size_t value = 1; value <= ITEMS_NUMBER; value++ )
+  {
+    SetItem( &item, value );
+    TSQ_Enqueue( test->queue, &item, TSQUEUE_WAIT );
+  }
+  
+  return NULL;
+}
+
+// Consumer alternates copying and in place reads, while a small queue gets overwritten: 
+// items may be lost, but should never be torn, repeated or out of order
+static bool TestOverwriteWhileReading( enum TSQueueType type )
+{
+  TestQueue test = { .queue = TSQ_CreateType( SMALL_QUEUE_LENGTH, sizeof(TestItem), type ), .isDone = false };
+  Thread producer = Thread_Start( ProduceOverwriting, &test, THREAD_JOINABLE );
+  if( producer == THREAD_INVALID_HANDLE ) return false;
+  
+  bool isSuccess = true;
+  size_t lastValue = 0;
+  for( size_t iteration = 0; isSuccess; iteration++ )
+  {
+    bool isProducerDone = __atomic_load_n( &(test.isDone), __ATOMIC_ACQUIRE );
+    TestItem item;
+    if( iteration % 2 == 0 )
+    {
+      if( !TSQ_Dequeue( test.queue, &item, TSQUEUE_NOWAIT ) ) 
+      {
+        if( isProducerDone ) break;
+        continue;
+      }
+    }
+    else
+    {
+      TestItem* slotItem = (TestItem*) TSQ_PeekRead( test.queue, TSQUEUE_NOWAIT );
+      if( slotItem == NULL )
+      {
+        if( isProducerDone ) break;
+        continue;
+      }
+      item = *slotItem;
+      Atomic_Yield();
+      if( !IsItemValid( slotItem ) || slotItem->values[ 0 ] != item.values[ 0 ] ) isSuccess = false;
+      TSQ_ReleaseRead( test.queue, slotItem );
+    }
+    if( !IsItemValid( &item ) || item.values[ 0 ] <= lastValue ) isSuccess = false;
+    lastValue = item.values[ 0 ];
+  }
+  
+  Thread_WaitExit( producer, INFINITE );
+  TSQ_Discard( test.queue );
+  
+  return isSuccess;
+}
+
+// Without overwriting, every item is received in order
+static bool TestWaitingTransfer( enum TSQueueType type )
+{
+  TestQueue test = { .queue = TSQ_CreateType( SMALL_QUEUE_LENGTH, sizeof(TestItem), type ), .isDone = false };
+  Thread producer = Thread_Start( ProduceWaiting, &test, THREAD_JOINABLE );
+  if( producer == THREAD_INVALID_HANDLE ) return false;
+  
+  bool isSuccess = true;
+  for( size_t value = 1; value <= ITEMS_NUMBER; value++ )
+  {
+    TestItem item;
+    if( !TSQ_Dequeue( test.queue, &item, TSQUEUE_WAIT ) || !IsItemValid( &item ) || item.values[ 0 ] != value ) isSuccess = false;
+  }
+  
+  Thread_WaitExit( producer, INFINITE );
+  if( TSQ_GetItemsCount( test.queue ) != 0 ) isSuccess = false;
+  TSQ_Discard( test.queue );
+  
+  return isSuccess;
+}
+
+static void* ProduceUntilDone( void* args )
+{
+  TestQueue* test = (TestQueue*) args;
+  TestItem item;
+  for( size_t value = 1; !__atomic_load_n( &(test->isDone), __ATOMIC_ACQUIRE ); value++ )
+  {
+    SetItem( &item, value );
+    TSQ_Enqueue( test->queue, &item, TSQUEUE_NOWAIT );
+  }
+  
+  return NULL;
+}
+
+// Sets get repeatedly created and discarded while insertions keep notifying them
+static bool TestSetDiscardWhileInserting( enum TSQueueType type )
+{
+  TestQueue test = { .queue = TSQ_CreateType( SMALL_QUEUE_LENGTH, sizeof(TestItem), type ), .isDone = false };
+  Thread producer = Thread_Start( ProduceUntilDone, &test, THREAD_JOINABLE );
+  if( producer == THREAD_INVALID_HANDLE ) return false;
+  
+  bool isSuccess = true;
+  for( size_t iteration = 0; iteration < SET_ITERATIONS_NUMBER; iteration++ )
+  {
+    TSQueueSet set = TSQ_CreateSet();
+    if( !TSQ_AddToSet( set, test.queue ) ) isSuccess = false;
+    TSQueue readyQueue;
+    if( TSQ_WaitSet( set, &readyQueue, 1, INFINITE ) != 1 || readyQueue != test.queue ) isSuccess = false;
+    if( iteration % 2 == 0 ) TSQ_RemoveFromSet( set, test.queue );
+    TSQ_DiscardSet( set );
+  }
+  
+  __atomic_store_n( &(test.isDone), true, __ATOMIC_RELEASE );
+  Thread_WaitExit( producer, INFINITE );
+  TSQ_Discard( test.queue );
+  
+  return isSuccess;
+}
+
+// Unbounded queue growth gets limited by the process address space: insertions past it fail, and the queue keeps working
+static bool TestUnboundedOutOfMemory()
+{
+#ifndef WIN32
+  struct rlimit initialLimit;
+  if( getrlimit( RLIMIT_AS, &initialLimit ) != 0 ) return true;
+  
+  TSQueue queue = TSQ_CreateType( 2, LARGE_ITEM_SIZE, TSQUEUE_UNBOUNDED );
+  uint8_t* item = (uint8_t*) calloc( 1, LARGE_ITEM_SIZE );
+  if( queue == NULL || item == NULL ) return false;
+  
+  // Leaves room for a few dozen items over the memory currently mapped
+  size_t mappedSize = 0;
+  FILE* statusFile = fopen( "/proc/self/statm", "r" );
+  if( statusFile == NULL || fscanf( statusFile, "%zu", &mappedSize ) != 1 ) mappedSize = 0;
+  if( statusFile != NULL ) fclose( statusFile );
+  if( mappedSize == 0 ) return true;
+  struct rlimit testLimit = { .rlim_cur = mappedSize * 4096 + 64 * LARGE_ITEM_SIZE, .rlim_max = initialLimit.rlim_max };
+  if( setrlimit( RLIMIT_AS, &testLimit ) != 0 ) return true;
+  
+  size_t insertedCount = 0;
+  while( insertedCount < MAX_LARGE_ITEMS_NUMBER && TSQ_Enqueue( queue, item, TSQUEUE_WAIT ) ) insertedCount++;
+  bool isReserveFailed = ( TSQ_ReserveWrite( queue, TSQUEUE_WAIT ) == NULL );
+  
+  setrlimit( RLIMIT_AS, &initialLimit );
+  
+  bool isSuccess = ( insertedCount < MAX_LARGE_ITEMS_NUMBER && isReserveFailed && TSQ_GetItemsCount( queue ) == insertedCount );
+  // Lock got released on failures, and memory is available again
+  if( !TSQ_Enqueue( queue, item, TSQUEUE_WAIT ) ) isSuccess = false;
+  size_t removedCount = 0;
+  while( TSQ_Dequeue( queue, item, TSQUEUE_NOWAIT ) ) removedCount++;
+  if( removedCount != insertedCount + 1 ) isSuccess = false;
+  
+  free( item );
+  TSQ_Discard( queue );
+  
+  return isSuccess;
+#else
+  return true;
+#endif
+}
+
+int main()
+{
+  bool isSuccess = true;
+  
+  const enum TSQueueType TYPES[] = { TSQUEUE_LOCKED, TSQUEUE_SPSC, TSQUEUE_MPMC };
+  const char* TYPE_NAMES[] = { "locked", "spsc", "mpmc" };
+  for( size_t typeIndex = 0; typeIndex < sizeof(TYPES) / sizeof(enum TSQueueType); typeIndex++ )
+  {
+    if( !TestWaitingTransfer( TYPES[ typeIndex ] ) ) { fprintf( stderr, "%s waiting transfer failed\n", TYPE_NAMES[ typeIndex ] ); isSuccess = false; }
+    if( !TestOverwriteWhileReading( TYPES[ typeIndex ] ) ) { fprintf( stderr, "%s overwrite while reading failed\n", TYPE_NAMES[ typeIndex ] ); isSuccess = false; }
+    if( !TestSetDiscardWhileInserting( TYPES[ typeIndex ] ) ) { fprintf( stderr, "%s set discard while inserting failed\n", TYPE_NAMES[ typeIndex ] ); isSuccess = false; }
+  }
+  
+  if( !TestUnboundedOutOfMemory() ) { fprintf( stderr, "unbounded out of memory failed\n" ); isSuccess = false; }
+  
+  return isSuccess ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,187 @@
+//////////////////////////////////////////////////////////////////////////////////////
+//                                                                                  //
+//  Copyright (c) 2016-2025 Leonardo Consoni <leonardojc@protonmail.com>             //
+//                                                                                  //
+//  This file is part of Simple Multithreading.                                     //
+//                                                                                  //
+//  Simple Multithreading is free software: you can redistribute it and/or modify   //
+//  it under the terms of the GNU Lesser General Public License as published        //
+//  by the Free Software Foundation, either version 3 of the License, or            //
+//  (at your option) any later version.                                             //
+//                                                                                  //
+//  Simple Multithreading is distributed in the hope that it will be useful,        //
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of                  //
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                    //
+//  GNU Lesser General Public License for more details.                             //
+//                                                                                  //
+//  You should have received a copy of the GNU Lesser General Public License        //
+//  along with Simple Multithreading. If not, see <http://www.gnu.org/licenses/>.   //
+//                                                                                  //
+//////////////////////////////////////////////////////////////////////////////////////
+
+
+/// @file thread_atomics.h
+/// @brief Platform agnostic helpers for lock-free synchronization.
+///
+/// Internal utilities shared by lock-free data structures and synchronization primitives:
+/// processor spin hints, monotonic time deadlines and blocking on changes of 32 bits 
+/// memory words (futex-like waiting), abstracting underlying operating system native calls
+/// (WaitOnAddress on Windows, futexes on Linux, hashed mutex/condition variable pairs on other POSIX systems).
+/// Atomic memory operations use the GCC/Clang __atomic builtins directly
+
+#ifndef THREAD_ATOMICS_H
+#define THREAD_ATOMICS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define ATOMIC_CACHE_LINE_SIZE 64                ///< Assumed cache line size (in bytes) for padding contended data
+#define ATOMIC_TIME_INFINITE UINT64_MAX          ///< Deadline value for waiting indefinitely
+
+#define THREAD_LOCAL __thread                    ///< Thread-local storage class specifier (GCC/Clang, as the __atomic builtins)
+
+/// @brief Hints the processor that caller is spinning on a busy-wait loop
+static inline void Atomic_Pause( void )
+{
+#if defined( __x86_64__ ) || defined( __i386__ )
+  __builtin_ia32_pause();
+#elif defined( __aarch64__ ) || defined( __arm__ )
+  __asm__ __volatile__( "yield" );
+#else
+  __atomic_signal_fence( __ATOMIC_SEQ_CST );
+#endif
+}
+
+#ifdef WIN32
+
+#include <Windows.h>
+
+/// @brief Gets current monotonic time
+/// @return time (in nanoseconds) elapsed since an arbitrary fixed point
+static inline uint64_t Atomic_GetTime( void )
+{
+  LARGE_INTEGER frequency, counter;
+  QueryPerformanceFrequency( &frequency );
+  QueryPerformanceCounter( &counter );
+  return (uint64_t) ( counter.QuadPart / frequency.QuadPart ) * 1000000000 + 
+         (uint64_t) ( counter.QuadPart % frequency.QuadPart ) * 1000000000 / frequency.QuadPart;
+}
+
+/// @brief Yields calling thread processor time to other ready threads
+static inline void Atomic_Yield( void ) { SwitchToThread(); }
+
+// Blocks calling thread while given memory word holds the expected value (see Atomic_Wait())
+static inline bool Atomic_WaitThread( volatile uint32_t* address, uint32_t expected, uint64_t deadline )
+{
+  DWORD milliseconds = INFINITE;
+  if( deadline != ATOMIC_TIME_INFINITE )
+  {
+    uint64_t now = Atomic_GetTime();
+    if( now >= deadline ) return false;
+    milliseconds = (DWORD) ( ( deadline - now + 999999 ) / 1000000 );
+  }
+  if( WaitOnAddress( address, &expected, sizeof(uint32_t), milliseconds ) ) return true;
+  return ( GetLastError() != ERROR_TIMEOUT );
+}
+
+// Awakes threads blocked on changes of given memory word (see Atomic_Wake())
+static inline void Atomic_WakeThreads( volatile uint32_t* address, bool all )
+{
+  if( all ) WakeByAddressAll( (PVOID) address );
+  else WakeByAddressSingle( (PVOID) address );
+}
+
+#else // Unix
+
+#include <unistd.h>
+#include <limits.h>
+#include <sched.h>
+#include <errno.h>
+#include <time.h>
+
+static inline uint64_t Atomic_GetTime( void )
+{
+  struct timespec now;
+  clock_gettime( CLOCK_MONOTONIC, &now );
+  return (uint64_t) now.tv_sec * 1000000000 + (uint64_t) now.tv_nsec;
+}
+
+static inline void Atomic_Yield( void ) { sched_yield(); }
+
+#ifdef __linux__
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+
+static inline bool Atomic_WaitThread( volatile uint32_t* address, uint32_t expected, uint64_t deadline )
+{
+  struct timespec timeout = { .tv_sec = (time_t) ( deadline / 1000000000 ), .tv_nsec = (long) ( deadline % 1000000000 ) };
+  // FUTEX_WAIT_BITSET takes an absolute CLOCK_MONOTONIC timeout, so deadlines hold across spurious returns
+  if( syscall( SYS_futex, address, FUTEX_WAIT_BITSET_PRIVATE, expected, 
+               ( deadline == ATOMIC_TIME_INFINITE ) ? NULL : &timeout, NULL, FUTEX_BITSET_MATCH_ANY ) == 0 ) return true;
+  return ( errno != ETIMEDOUT );
+}
+
+static inline void Atomic_WakeThreads( volatile uint32_t* address, bool all )
+{
+  syscall( SYS_futex, address, FUTEX_WAKE_PRIVATE, all ? INT_MAX : 1, NULL, NULL, 0 );
+}
+
+#else
+
+// Without futexes, waiting is emulated with mutex/condition variable pairs picked by address hash (implemented in threads.c)
+bool Atomic_WaitThread( volatile uint32_t* address, uint32_t expected, uint64_t deadline );
+void Atomic_WakeThreads( volatile uint32_t* address, bool all );
+
+#endif // __linux__
+
+#endif // WIN32
+
+// Suspends calling fiber (if any) while given memory word holds the expected value (implemented in fibers.c)
+bool Fibers_Park( volatile uint32_t* address, uint32_t expected );
+// Resumes fibers suspended on changes of given memory word (implemented in fibers.c)
+void Fibers_Unpark( volatile uint32_t* address, bool all );
+
+/// @brief Blocks calling thread while given memory word holds the expected value (spurious returns are possible)
+/// @param[in] address pointer to the watched memory word
+/// @param[in] expected value for which calling thread should keep waiting
+/// @param[in] deadline monotonic time (in nanoseconds) at which waiting is aborted (ATOMIC_TIME_INFINITE to wait indefinitely)
+/// @return false if deadline was reached, true otherwise
+static inline bool Atomic_Wait( volatile uint32_t* address, uint32_t expected, uint64_t deadline )
+{
+  // Code running on a fiber suspends only the fiber (timed waits still block its carrier thread)
+  if( deadline == ATOMIC_TIME_INFINITE && Fibers_Park( address, expected ) ) return true;
+  return Atomic_WaitThread( address, expected, deadline );
+}
+
+/// @brief Awakes threads (and fibers) blocked on changes of given memory word
+/// @param[in] address pointer to the watched memory word
+/// @param[in] all true to awake all blocked threads, false to awake a single one
+static inline void Atomic_Wake( volatile uint32_t* address, bool all )
+{
+  Fibers_Unpark( address, all );
+  Atomic_WakeThreads( address, all );
+}
+
+/// @brief Converts relative timeout to absolute monotonic deadline
+/// @param[in] milliseconds timeout (in milliseconds) from now (0xFFFFFFFF to wait indefinitely)
+/// @return monotonic deadline time (in nanoseconds), or ATOMIC_TIME_INFINITE
+static inline uint64_t Atomic_GetDeadline( unsigned int milliseconds )
+{
+  if( milliseconds == 0xFFFFFFFF ) return ATOMIC_TIME_INFINITE;
+  return Atomic_GetTime() + (uint64_t) milliseconds * 1000000;
+}
+
+/// @brief Converts absolute monotonic deadline back to relative timeout
+/// @param[in] deadline monotonic time (in nanoseconds), or ATOMIC_TIME_INFINITE
+/// @return remaining time (in milliseconds, rounded up) until deadline (0 if already reached, 0xFFFFFFFF if infinite)
+static inline unsigned int Atomic_GetTimeout( uint64_t deadline )
+{
+  if( deadline == ATOMIC_TIME_INFINITE ) return 0xFFFFFFFF;
+  uint64_t now = Atomic_GetTime();
+  if( now >= deadline ) return 0;
+  uint64_t milliseconds = ( deadline - now + 999999 ) / 1000000;
+  return ( milliseconds < 0xFFFFFFFF ) ? (unsigned int) milliseconds : 0xFFFFFFFE;
+}
+
+#endif // THREAD_ATOMICS_H
@@ -0,0 +1,159 @@
+//////////////////////////////////////////////////////////////////////////////////////
+//                                                                                  //
+//  Copyright (c) 2016-2025 Leonardo Consoni <leonardojc@protonmail.com>            //
+//                                                                                  //
+//  This file is part of Simple Multithreading.                                     //
+//                                                                                  //
+//  Simple Multithreading is free software: you can redistribute it and/or modify   //
+//  it under the terms of the GNU Lesser General Public License as published        //
+//  by the Free Software Foundation, either version 3 of the License, or            //
+//  (at your option) any later version.                                             //
+//                                                                                  //
+//  Simple Multithreading is distributed in the hope that it will be useful,        //
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of                  //
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                    //
+//  GNU Lesser General Public License for more details.                             //
+//                                                                                  //
+//  You should have received a copy of the GNU Lesser General Public License        //
+//  along with Simple Multithreading. If not, see <http://www.gnu.org/licenses/>.   //
+//                                                                                  //
+//////////////////////////////////////////////////////////////////////////////////////
+
+#include "thread_atomics.h"
+
+#include "thread_barriers.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static const size_t BARRIER_SPIN_COUNT = 2000;
+static const size_t BARRIER_YIELD_INTERVAL = 64;
+static const size_t LATCH_SPIN_COUNT = 100;
+
+// Arrivals and phase changes stay on different cache lines, so that spinning 
+// waiters are only disturbed once per phase, by the last arriving thread
+struct _TBarrierData
+{
+  volatile uint32_t remainingCount;
+  uint32_t threadsCount;
+  uint8_t arrivalPadding[ ATOMIC_CACHE_LINE_SIZE - 2 * sizeof(uint32_t) ];
+  volatile uint32_t phase;              // Incremented (sense reversed) by the last arriving thread
+  volatile uint32_t sleepersCount;
+};
+
+struct _TLatchData
+{
+  volatile uint32_t count;
+  volatile uint32_t sleepersCount;
+};
+
+
+TBarrier TBarrier_Create( size_t threadsCount )
+{
+  if( threadsCount == 0 || threadsCount > UINT32_MAX ) return NULL;
+  
+  TBarrier newBarrier = NULL;
+#ifdef WIN32
+  newBarrier = (TBarrier) _aligned_malloc( sizeof(TBarrierData), ATOMIC_CACHE_LINE_SIZE );
+#else
+  if( posix_memalign( (void**) &newBarrier, ATOMIC_CACHE_LINE_SIZE, sizeof(TBarrierData) ) != 0 ) return NULL;
+#endif
+  if( newBarrier == NULL ) return NULL;
+  
+  memset( newBarrier, 0, sizeof(TBarrierData) );
+  newBarrier->threadsCount = (uint32_t) threadsCount;
+  newBarrier->remainingCount = (uint32_t) threadsCount;
+  
+  return newBarrier;
+}
+
+void TBarrier_Discard( TBarrier barrier )
+{
+  if( barrier == NULL ) return;
+  
+#ifdef WIN32
+  _aligned_free( barrier );
+#else
+  free( barrier );
+#endif
+}
+
+bool TBarrier_Wait( TBarrier barrier )
+{
+  uint32_t phase = __atomic_load_n( &(barrier->phase), __ATOMIC_ACQUIRE );
+  
+  if( __atomic_sub_fetch( &(barrier->remainingCount), 1, __ATOMIC_ACQ_REL ) == 0 )
+  {
+    // Nobody proceeds before the phase change, so arrivals of the next phase can't be counted too early
+    __atomic_store_n( &(barrier->remainingCount), barrier->threadsCount, __ATOMIC_RELAXED );
+    __atomic_store_n( &(barrier->phase), phase + 1, __ATOMIC_SEQ_CST );
+    if( __atomic_load_n( &(barrier->sleepersCount), __ATOMIC_SEQ_CST ) > 0 ) Atomic_Wake( &(barrier->phase), true );
+    return true;
+  }
+  
+  for( size_t spinsCount = 0; spinsCount < BARRIER_SPIN_COUNT; spinsCount++ )
+  {
+    if( __atomic_load_n( &(barrier->phase), __ATOMIC_ACQUIRE ) != phase ) return false;
+    // Periodically yielding lets late threads run when there are more threads than processors
+    if( ( spinsCount + 1 ) % BARRIER_YIELD_INTERVAL == 0 ) Atomic_Yield();
+    else Atomic_Pause();
+  }
+  
+  __atomic_fetch_add( &(barrier->sleepersCount), 1, __ATOMIC_SEQ_CST );
+  while( __atomic_load_n( &(barrier->phase), __ATOMIC_ACQUIRE ) == phase )
+    Atomic_Wait( &(barrier->phase), phase, ATOMIC_TIME_INFINITE );
+  __atomic_fetch_sub( &(barrier->sleepersCount), 1, __ATOMIC_RELAXED );
+  
+  return false;
+}
+
+
+TLatch TLatch_Create( size_t count )
+{
+  TLatch newLatch = (TLatch) malloc( sizeof(TLatchData) );
+  newLatch->count = ( count < UINT32_MAX ) ? (uint32_t) count : UINT32_MAX;
+  newLatch->sleepersCount = 0;
+  
+  return newLatch;
+}
+
+void TLatch_Discard( TLatch latch )
+{
+  if( latch == NULL ) return;
+  
+  free( latch );
+}
+
+void TLatch_CountDown( TLatch latch, size_t count )
+{
+  uint32_t currentCount = __atomic_load_n( &(latch->count), __ATOMIC_RELAXED );
+  uint32_t newCount;
+  do
+  {
+    if( currentCount == 0 ) return;
+    newCount = ( count < currentCount ) ? currentCount - (uint32_t) count : 0;
+  }
+  while( !__atomic_compare_exchange_n( &(latch->count), &currentCount, newCount, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED ) );
+  
+  if( newCount == 0 && __atomic_load_n( &(latch->sleepersCount), __ATOMIC_SEQ_CST ) > 0 ) Atomic_Wake( &(latch->count), true );
+}
+
+bool TLatch_Wait( TLatch latch, unsigned int milliseconds )
+{
+  for( size_t spinsCount = 0; spinsCount < LATCH_SPIN_COUNT; spinsCount++ )
+  {
+    if( __atomic_load_n( &(latch->count), __ATOMIC_ACQUIRE ) == 0 ) return true;
+    Atomic_Pause();
+  }
+  if( milliseconds == 0 ) return false;
+  
+  uint64_t deadline = Atomic_GetDeadline( milliseconds );
+  bool isTimedOut = false;
+  __atomic_fetch_add( &(latch->sleepersCount), 1, __ATOMIC_SEQ_CST );
+  uint32_t count;
+  while( ( count = __atomic_load_n( &(latch->count), __ATOMIC_ACQUIRE ) ) > 0 && !isTimedOut )
+    isTimedOut = !Atomic_Wait( &(latch->count), count, deadline );
+  __atomic_fetch_sub( &(latch->sleepersCount), 1, __ATOMIC_RELAXED );
+  
+  return ( count == 0 );
+}
@@ -0,0 +1,82 @@
+//////////////////////////////////////////////////////////////////////////////////////
+//                                                                                  //
+//  Copyright (c) 2016-2025 Leonardo Consoni <leonardojc@protonmail.com>             //
+//                                                                                  //
+//  This file is part of Simple Multithreading.                                     //
+//                                                                                  //
+//  Simple Multithreading is free software: you can redistribute it and/or modify   //
+//  it under the terms of the GNU Lesser General Public License as published        //
+//  by the Free Software Foundation, either version 3 of the License, or            //
+//  (at your option) any later version.                                             //
+//                                                                                  //
+//  Simple Multithreading is distributed in the hope that it will be useful,        //
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of                  //
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                    //
+//  GNU Lesser General Public License for more details.                             //
+//                                                                                  //
+//  You should have received a copy of the GNU Lesser General Public License        //
+//  along with Simple Multithreading. If not, see <http://www.gnu.org/licenses/>.   //
+//                                                                                  //
+//////////////////////////////////////////////////////////////////////////////////////
+
+
+/// @file thread_barriers.h
+/// @brief Platform agnostic barriers and latches.
+///
+/// Primitives for making groups of threads proceed together: reusable barriers, for running 
+/// lock-step phases, and one-shot countdown latches, for waiting on a number of events
+
+#ifndef THREAD_BARRIERS_H
+#define THREAD_BARRIERS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/// Structure holding single barrier data
+typedef struct _TBarrierData TBarrierData;
+/// Opaque reference to barrier data
+typedef TBarrierData* TBarrier;
+
+/// Structure holding single latch data
+typedef struct _TLatchData TLatchData;
+/// Opaque reference to latch data
+typedef TLatchData* TLatch;
+
+
+/// @brief Request new reusable barrier
+/// @param[in] threadsCount number of threads that should reach the barrier for all of them to proceed
+/// @return newly created barrier reference (NULL on errors)
+TBarrier TBarrier_Create( size_t threadsCount );
+
+/// @brief Discards given barrier data (no thread should be waiting on it)
+/// @param[in] barrier barrier reference
+void TBarrier_Discard( TBarrier barrier );
+
+/// @brief Blocks calling thread until all others of the group reach the barrier as well (briefly spinning before sleeping)
+/// @param[in] barrier barrier reference
+/// @return true for the last thread reaching the barrier in current phase, false for the others
+bool TBarrier_Wait( TBarrier barrier );
+
+/// @brief Request new one-shot countdown latch
+/// @param[in] count number of count downs required for releasing waiting threads
+/// @return newly created latch reference
+TLatch TLatch_Create( size_t count );
+
+/// @brief Discards given latch data (no thread should be waiting on it)
+/// @param[in] latch latch reference
+void TLatch_Discard( TLatch latch );
+
+/// @brief Decreases latch count, releasing all waiting threads when it gets to zero
+/// @param[in] latch latch reference
+/// @param[in] count number of count downs (limited to remaining count)
+void TLatch_CountDown( TLatch latch, size_t count );
+
+/// @brief Blocks calling thread until latch count gets to zero
+/// @param[in] latch latch reference
+/// @param[in] milliseconds maximum time (in milliseconds, measured with monotonic clock) for waiting (INFINITE to wait indefinitely)
+/// @return true if latch got released, false on timeout
+bool TLatch_Wait( TLatch latch, unsigned int milliseconds );
+
+
+#endif // THREAD_BARRIERS_H
@@ -0,0 +1,140 @@
+//////////////////////////////////////////////////////////////////////////////////////
+//                                                                                  //
+//  Copyright (c) 2016-2025 Leonardo Consoni <leonardojc@protonmail.com>            //
+//                                                                                  //
+//  This file is part of Simple Multithreading.                                     //
+//                                                                                  //
+//  Simple Multithreading is free software: you can redistribute it and/or modify   //
+//  it under the terms of the GNU Lesser General Public License as published        //
+//  by the Free Software Foundation, either version 3 of the License, or            //
+//  (at your option) any later version.                                             //
+//                                                                                  //
+//  Simple Multithreading is distributed in the hope that it will be useful,        //
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of                  //
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                    //
+//  GNU Lesser General Public License for more details.                             //
+//                                                                                  //
+//  You should have received a copy of the GNU Lesser General Public License        //
+//  along with Simple Multithreading. If not, see <http://www.gnu.org/licenses/>.   //
+//                                                                                  //
+//////////////////////////////////////////////////////////////////////////////////////
+
+#include "thread_atomics.h"
+
+#include "thread_events.h"
+
+#include <stdlib.h>
+
+// Waiting threads block on changes of the sequence word, incremented on every signal/notification.
+// Counting waiters lets signaling skip system calls if nobody is blocked
+struct _TCondData
+{
+  volatile uint32_t sequence;
+  volatile uint32_t waitersCount;
+};
+
+// Event count word holds the notification epoch on its upper bits, and a flag marking the presence of 
+// possible waiters on the lowest one. The flag is cleared on notification, so that notifying again 
+// costs no system call until some thread prepares to wait again
+#define EPOCH_WAITERS_FLAG 1
+#define EPOCH_INCREMENT 2
+
+struct _TEventCountData
+{
+  volatile uint32_t epoch;
+};
+
+
+TCond TCond_Create()
+{
+  TCond newCond = (TCond) malloc( sizeof(TCondData) );
+  newCond->sequence = 0;
+  newCond->waitersCount = 0;
+  
+  return newCond;
+}
+
+void TCond_Discard( TCond cond )
+{
+  if( cond == NULL ) return;
+  
+  free( cond );
+}
+
+bool TCond_Wait( TCond cond, TLock lock, unsigned int milliseconds )
+{
+  uint64_t deadline = Atomic_GetDeadline( milliseconds );
+  
+  // Sequence is read while lock is still held, so signals sent after releasing it aren't missed
+  uint32_t sequence = __atomic_load_n( &(cond->sequence), __ATOMIC_SEQ_CST );
+  __atomic_fetch_add( &(cond->waitersCount), 1, __ATOMIC_SEQ_CST );
+  TLock_Release( lock );
+  
+  bool isSignaled = Atomic_Wait( &(cond->sequence), sequence, deadline );
+  
+  __atomic_fetch_sub( &(cond->waitersCount), 1, __ATOMIC_RELAXED );
+  TLock_Acquire( lock );
+  
+  return isSignaled;
+}
+
+void TCond_Signal( TCond cond )
+{
+  __atomic_fetch_add( &(cond->sequence), 1, __ATOMIC_SEQ_CST );
+  if( __atomic_load_n( &(cond->waitersCount), __ATOMIC_SEQ_CST ) > 0 ) Atomic_Wake( &(cond->sequence), false );
+}
+
+void TCond_Broadcast( TCond cond )
+{
+  __atomic_fetch_add( &(cond->sequence), 1, __ATOMIC_SEQ_CST );
+  if( __atomic_load_n( &(cond->waitersCount), __ATOMIC_SEQ_CST ) > 0 ) Atomic_Wake( &(cond->sequence), true );
+}
+
+
+TEventCount TEventCount_Create()
+{
+  TEventCount newEvent = (TEventCount) malloc( sizeof(TEventCountData) );
+  newEvent->epoch = 0;
+  
+  return newEvent;
+}
+
+void TEventCount_Discard( TEventCount event )
+{
+  if( event == NULL ) return;
+  
+  free( event );
+}
+
+// Waiter registration is ordered before the condition check, and notifier fence orders the condition change 
+// before the waiters check: either the waiter sees the change, or the notifier sees the waiter
+uint32_t TEventCount_PrepareWait( TEventCount event )
+{
+  return __atomic_or_fetch( &(event->epoch), EPOCH_WAITERS_FLAG, __ATOMIC_SEQ_CST );
+}
+
+bool TEventCount_CommitWait( TEventCount event, uint32_t key, unsigned int milliseconds )
+{
+  return Atomic_Wait( &(event->epoch), key, Atomic_GetDeadline( milliseconds ) );
+}
+
+void TEventCount_CancelWait( TEventCount event )
+{
+  // Flag stays set, as other threads might still be waiting: a later notification clears it
+  (void) event;
+}
+
+void TEventCount_Notify( TEventCount event )
+{
+  __atomic_thread_fence( __ATOMIC_SEQ_CST );
+  uint32_t epoch = __atomic_load_n( &(event->epoch), __ATOMIC_RELAXED );
+  if( !( epoch & EPOCH_WAITERS_FLAG ) ) return;
+  
+  // Every waiter registered before is awaken, as a single wake up could be taken by one that won't consume the event
+  while( !__atomic_compare_exchange_n( &(event->epoch), &epoch, ( epoch + EPOCH_INCREMENT ) & ~EPOCH_WAITERS_FLAG, 
+                                       false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED ) )
+  {
+    if( !( epoch & EPOCH_WAITERS_FLAG ) ) return;
+  }
+  Atomic_Wake( &(event->epoch), true );
+}
@@ -0,0 +1,102 @@
+//////////////////////////////////////////////////////////////////////////////////////
+//                                                                                  //
+//  Copyright (c) 2016-2025 Leonardo Consoni <leonardojc@protonmail.com>             //
+//                                                                                  //
+//  This file is part of Simple Multithreading.                                     //
+//                                                                                  //
+//  Simple Multithreading is free software: you can redistribute it and/or modify   //
+//  it under the terms of the GNU Lesser General Public License as published        //
+//  by the Free Software Foundation, either version 3 of the License, or            //
+//  (at your option) any later version.                                             //
+//                                                                                  //
+//  Simple Multithreading is distributed in the hope that it will be useful,        //
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of                  //
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                    //
+//  GNU Lesser General Public License for more details.                             //
+//                                                                                  //
+//  You should have received a copy of the GNU Lesser General Public License        //
+//  along with Simple Multithreading. If not, see <http://www.gnu.org/licenses/>.   //
+//                                                                                  //
+//////////////////////////////////////////////////////////////////////////////////////
+
+
+/// @file thread_events.h
+/// @brief Platform agnostic condition variables and event counts.
+///
+/// Primitives for blocking threads until some condition on shared data changes: condition 
+/// variables (used together with a lock that protects that data) and event counts, that let 
+/// lock-free producers awake waiting consumers while avoiding system calls when nobody waits
+
+#ifndef THREAD_EVENTS_H
+#define THREAD_EVENTS_H
+
+#include "thread_locks.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/// Structure holding single condition variable data
+typedef struct _TCondData TCondData;
+/// Opaque reference to condition variable data
+typedef TCondData* TCond;
+
+/// Structure holding single event count data
+typedef struct _TEventCountData TEventCountData;
+/// Opaque reference to event count data
+typedef TEventCountData* TEventCount;
+
+
+/// @brief Request new condition variable
+/// @return newly created condition variable reference
+TCond TCond_Create();
+
+/// @brief Discards given condition variable data
+/// @param[in] cond condition variable reference
+void TCond_Discard( TCond cond );
+
+/// @brief Atomically releases given lock and blocks calling thread until condition variable is signaled (spurious returns are possible)
+/// @param[in] cond condition variable reference
+/// @param[in] lock mutex reference (should be acquired by calling thread, and is acquired again on return)
+/// @param[in] milliseconds maximum time (in milliseconds, measured with monotonic clock) for waiting (INFINITE to wait indefinitely)
+/// @return true if signaled (or spuriously awaken), false on timeout
+bool TCond_Wait( TCond cond, TLock lock, unsigned int milliseconds );
+
+/// @brief Awakes one of the threads waiting on given condition variable, if any
+/// @param[in] cond condition variable reference
+void TCond_Signal( TCond cond );
+
+/// @brief Awakes all threads waiting on given condition variable
+/// @param[in] cond condition variable reference
+void TCond_Broadcast( TCond cond );
+
+/// @brief Request new event count
+/// @return newly created event count reference
+TEventCount TEventCount_Create();
+
+/// @brief Discards given event count data
+/// @param[in] event event count reference
+void TEventCount_Discard( TEventCount event );
+
+/// @brief Registers calling thread as about to wait (should be followed by checking the awaited condition, then TEventCount_CommitWait() or TEventCount_CancelWait())
+/// @param[in] event event count reference
+/// @return key identifying current notification epoch, for TEventCount_CommitWait()
+uint32_t TEventCount_PrepareWait( TEventCount event );
+
+/// @brief Blocks calling thread until a notification after TEventCount_PrepareWait() call (returns immediately if one already happened)
+/// @param[in] event event count reference
+/// @param[in] key value returned by preceding TEventCount_PrepareWait() call
+/// @param[in] milliseconds maximum time (in milliseconds, measured with monotonic clock) for waiting (INFINITE to wait indefinitely)
+/// @return true if notified (or spuriously awaken), false on timeout
+bool TEventCount_CommitWait( TEventCount event, uint32_t key, unsigned int milliseconds );
+
+/// @brief Unregisters calling thread as waiter, when awaited condition was found satisfied after TEventCount_PrepareWait()
+/// @param[in] event event count reference
+void TEventCount_CancelWait( TEventCount event );
+
+/// @brief Awakes all waiting threads (should be called after making the awaited condition true). Costs a memory fence and a single load 
+/// if nobody started waiting since last notification, so that bursts of notifications issue a single system call
+/// @param[in] event event count reference
+void TEventCount_Notify( TEventCount event );
+
+
+#endif // THREAD_EVENTS_H
@@ -0,0 +1,306 @@
+//////////////////////////////////////////////////////////////////////////////////////
+//                                                                                  //
+//  Copyright (c) 2016-2025 Leonardo Consoni <leonardojc@protonmail.com>            //
+//                                                                                  //
+//  This file is part of Simple Multithreading.                                     //
+//                                                                                  //
+//  Simple Multithreading is free software: you can redistribute it and/or modify   //
+//  it under the terms of the GNU Lesser General Public License as published        //
+//  by the Free Software Foundation, either version 3 of the License, or            //
+//  (at your option) any later version.                                             //
+//                                                                                  //
+//  Simple Multithreading is distributed in the hope that it will be useful,        //
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of                  //
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                    //
+//  GNU Lesser General Public License for more details.                             //
+//                                                                                  //
+//  You should have received a copy of the GNU Lesser General Public License        //
+//  along with Simple Multithreading. If not, see <http://www.gnu.org/licenses/>.   //
+//                                                                                  //
+//////////////////////////////////////////////////////////////////////////////////////
+
+#include "thread_atomics.h"
+#include "thread_locks.h"
+
+#include "thread_futures.h"
+
+#include <stdlib.h>
+
+enum { FUTURE_PENDING, FUTURE_DONE };
+
+// Continuation or group waiter registered on a pending future
+typedef struct _Listener
+{
+  AsyncFunction continuation;
+  Future future;
+  volatile uint32_t* signal;
+  struct _Listener* next;
+}
+Listener;
+
+// Asynchronous function call delivering its result to a future
+typedef struct _AsyncCall
+{
+  AsyncFunction function;
+  void* args;
+  Future future;
+}
+AsyncCall;
+
+struct _FutureData
+{
+  volatile uint32_t state;
+  volatile uint32_t waitersCount;
+  void* result;
+  volatile size_t referencesCount;
+  TLock listenersLock;
+  Listener* listeners;
+};
+
+
+static Future CreateFuture( size_t referencesCount )
+{
+  Future future = (Future) malloc( sizeof(FutureData) );
+  
+  future->state = FUTURE_PENDING;
+  future->waitersCount = 0;
+  future->result = NULL;
+  future->referencesCount = referencesCount;
+  future->listenersLock = TLock_Create();
+  future->listeners = NULL;
+  
+  return future;
+}
+
+static void ReleaseFuture( Future future )
+{
+  if( __atomic_sub_fetch( &(future->referencesCount), 1, __ATOMIC_ACQ_REL ) > 0 ) return;
+  
+  TLock_Discard( future->listenersLock );
+  free( future );
+}
+
+Future Future_Create()
+{
+  return CreateFuture( 1 );
+}
+
+// Runs asynchronous function on spawned thread, delivering its result
+static void* RunAsync( void* args )
+{
+  AsyncCall* call = (AsyncCall*) args;
+  
+  Future_Complete( call->future, call->function( call->args ) );
+  ReleaseFuture( call->future );
+  free( call );
+  
+  return NULL;
+}
+
+Future Future_Start( AsyncFunction function, void* args )
+{
+  if( function == NULL ) return NULL;
+  
+  // One reference for the caller and another for the running thread
+  Future future = CreateFuture( 2 );
+  
+  AsyncCall* call = (AsyncCall*) malloc( sizeof(AsyncCall) );
+  call->function = function;
+  call->args = args;
+  call->future = future;
+  
+  if( Thread_Start( RunAsync, (void*) call, THREAD_DETACHED ) == THREAD_INVALID_HANDLE )
+  {
+    free( call );
+    ReleaseFuture( future );
+    ReleaseFuture( future );
+    return NULL;
+  }
+  
+  return future;
+}
+
+void Future_Discard( Future future )
+{
+  if( future == NULL ) return;
+  
+  ReleaseFuture( future );
+}
+
+bool Future_Complete( Future future, void* result )
+{
+  if( future == NULL ) return false;
+  
+  // Woken waiters may discard the future (even the last reference) while its listeners are still being processed
+  __atomic_add_fetch( &(future->referencesCount), 1, __ATOMIC_RELAXED );
+  
+  TLock_Acquire( future->listenersLock );
+  if( future->state != FUTURE_PENDING )
+  {
+    TLock_Release( future->listenersLock );
+    ReleaseFuture( future );
+    return false;
+  }
+  future->result = result;
+  __atomic_store_n( &(future->state), FUTURE_DONE, __ATOMIC_SEQ_CST );
+  if( __atomic_load_n( &(future->waitersCount), __ATOMIC_SEQ_CST ) > 0 ) Atomic_Wake( &(future->state), true );
+  // Group waiters are signaled while locked, as they unregister (and deallocate) themselves under the same lock
+  Listener* continuations = NULL;
+  Listener* listener = future->listeners;
+  while( listener != NULL )
+  {
+    Listener* next = listener->next;
+    if( listener->signal != NULL )
+    {
+      __atomic_fetch_add( listener->signal, 1, __ATOMIC_RELEASE );
+      Atomic_Wake( listener->signal, true );
+    }
+    else
+    {
+      listener->next = continuations;
+      continuations = listener;
+    }
+    listener = next;
+  }
+  future->listeners = NULL;
+  TLock_Release( future->listenersLock );
+  ReleaseFuture( future );
+  
+  while( continuations != NULL )
+  {
+    Listener* next = continuations->next;
+    Future_Complete( continuations->future, continuations->continuation( result ) );
+    ReleaseFuture( continuations->future );
+    free( continuations );
+    continuations = next;
+  }
+  
+  return true;
+}
+
+bool Future_IsDone( Future future )
+{
+  if( future == NULL ) return false;
+  
+  return ( __atomic_load_n( &(future->state), __ATOMIC_ACQUIRE ) == FUTURE_DONE );
+}
+
+// Waits for future completion until given monotonic deadline
+static bool WaitFuture( Future future, uint64_t deadline )
+{
+  if( Future_IsDone( future ) ) return true;
+  
+  __atomic_fetch_add( &(future->waitersCount), 1, __ATOMIC_SEQ_CST );
+  while( __atomic_load_n( &(future->state), __ATOMIC_SEQ_CST ) == FUTURE_PENDING )
+  {
+    if( !Atomic_Wait( &(future->state), FUTURE_PENDING, deadline ) ) break;
+  }
+  __atomic_fetch_sub( &(future->waitersCount), 1, __ATOMIC_RELAXED );
+  
+  return Future_IsDone( future );
+}
+
+bool Future_Wait( Future future, unsigned int milliseconds )
+{
+  if( future == NULL ) return false;
+  
+  return WaitFuture( future, Atomic_GetDeadline( milliseconds ) );
+}
+
+void* Future_GetResult( Future future )
+{
+  if( !Future_IsDone( future ) ) return NULL;
+  
+  return future->result;
+}
+
+Future Future_Then( Future future, AsyncFunction continuation )
+{
+  if( future == NULL || continuation == NULL ) return NULL;
+  
+  // One reference for the caller and another for the pending continuation
+  Future nextFuture = CreateFuture( 2 );
+  
+  TLock_Acquire( future->listenersLock );
+  if( future->state == FUTURE_PENDING )
+  {
+    Listener* listener = (Listener*) malloc( sizeof(Listener) );
+    listener->continuation = continuation;
+    listener->future = nextFuture;
+    listener->signal = NULL;
+    listener->next = future->listeners;
+    future->listeners = listener;
+    TLock_Release( future->listenersLock );
+    return nextFuture;
+  }
+  TLock_Release( future->listenersLock );
+  
+  Future_Complete( nextFuture, continuation( future->result ) );
+  ReleaseFuture( nextFuture );
+  
+  return nextFuture;
+}
+
+int Future_WaitAny( Future* futures, size_t count, unsigned int milliseconds )
+{
+  if( futures == NULL || count == 0 ) return FUTURE_INVALID_INDEX;
+  
+  for( size_t i = 0; i < count; i++ )
+  {
+    if( Future_IsDone( futures[ i ] ) ) return (int) i;
+  }
+  
+  if( milliseconds == 0 ) return FUTURE_INVALID_INDEX;
+  
+  uint64_t deadline = Atomic_GetDeadline( milliseconds );
+  volatile uint32_t signal = 0;
+  
+  // Single shared word for the whole group, signaled by any completion
+  Listener* waiters = (Listener*) calloc( count, sizeof(Listener) );
+  for( size_t i = 0; i < count; i++ )
+  {
+    if( futures[ i ] == NULL ) continue;
+    waiters[ i ].signal = &signal;
+    TLock_Acquire( futures[ i ]->listenersLock );
+    waiters[ i ].next = futures[ i ]->listeners;
+    futures[ i ]->listeners = &(waiters[ i ]);
+    TLock_Release( futures[ i ]->listenersLock );
+  }
+  
+  int doneIndex = FUTURE_INVALID_INDEX;
+  while( doneIndex == FUTURE_INVALID_INDEX )
+  {
+    uint32_t lastSignal = __atomic_load_n( &signal, __ATOMIC_ACQUIRE );
+    for( size_t i = 0; i < count && doneIndex == FUTURE_INVALID_INDEX; i++ )
+    {
+      if( Future_IsDone( futures[ i ] ) ) doneIndex = (int) i;
+    }
+    if( doneIndex == FUTURE_INVALID_INDEX && !Atomic_Wait( &signal, lastSignal, deadline ) ) break;
+  }
+  
+  for( size_t i = 0; i < count; i++ )
+  {
+    if( futures[ i ] == NULL ) continue;
+    TLock_Acquire( futures[ i ]->listenersLock );
+    Listener** link = &(futures[ i ]->listeners);
+    while( *link != NULL && *link != &(waiters[ i ]) ) link = &((*link)->next);
+    if( *link != NULL ) *link = waiters[ i ].next;
+    TLock_Release( futures[ i ]->listenersLock );
+  }
+  free( waiters );
+  
+  return doneIndex;
+}
+
+bool Future_WaitAll( Future* futures, size_t count, unsigned int milliseconds )
+{
+  if( futures == NULL ) return false;
+  
+  uint64_t deadline = Atomic_GetDeadline( milliseconds );
+  for( size_t i = 0; i < count; i++ )
+  {
+    if( futures[ i ] == NULL || !WaitFuture( futures[ i ], deadline ) ) return false;
+  }
+  
+  return true;
+}
@@ -0,0 +1,100 @@
+//////////////////////////////////////////////////////////////////////////////////////
+//                                                                                  //
+//  Copyright (c) 2016-2025 Leonardo Consoni <leonardojc@protonmail.com>             //
+//                                                                                  //
+//  This file is part of Simple Multithreading.                                     //
+//                                                                                  //
+//  Simple Multithreading is free software: you can redistribute it and/or modify   //
+//  it under the terms of the GNU Lesser General Public License as published        //
+//  by the Free Software Foundation, either version 3 of the License, or            //
+//  (at your option) any later version.                                             //
+//                                                                                  //
+//  Simple Multithreading is distributed in the hope that it will be useful,        //
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of                  //
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                    //
+//  GNU Lesser General Public License for more details.                             //
+//                                                                                  //
+//  You should have received a copy of the GNU Lesser General Public License        //
+//  along with Simple Multithreading. If not, see <http://www.gnu.org/licenses/>.   //
+//                                                                                  //
+//////////////////////////////////////////////////////////////////////////////////////
+
+
+/// @file thread_futures.h
+/// @brief Futures/promises for results of asynchronous functions.
+///
+/// Handles to values produced asynchronously, that can be waited on (with timeouts), 
+/// chained with continuations and grouped, without creating helper threads for waiting
+
+#ifndef THREAD_FUTURES_H
+#define THREAD_FUTURES_H
+
+#include "threads.h"
+
+#include <stdbool.h>
+
+/// Structure holding single future data
+typedef struct _FutureData FutureData;
+/// Opaque reference to future data structure
+typedef FutureData* Future;
+
+#define FUTURE_INVALID_INDEX -1      ///< Index returned when no future of a group got completed
+
+                                                                            
+/// @brief Creates pending future (promise), to be completed later with Future_Complete()
+/// @return reference to newly created future
+Future Future_Create();
+
+/// @brief Setups new detached thread to run the given method asynchronously, with its return value delivered through a future
+/// @param[in] function pointer to the function that will run on spawned thread                                   
+/// @param[in] args opaque pointer to struct that will be passed as the thread function argument                                         
+/// @return reference to future of the function return value (NULL on errors)
+Future Future_Start( AsyncFunction function, void* args );
+
+/// @brief Releases caller reference to given future (its data is deallocated after pending completions and continuations)
+/// @param[in] future reference to future
+void Future_Discard( Future future );
+
+/// @brief Sets result of given pending future, awaking waiting threads and running its continuations on calling thread
+/// @param[in] future reference to future
+/// @param[in] result opaque pointer to produced value
+/// @return true on successful completion, false if future was already completed
+bool Future_Complete( Future future, void* result );
+
+/// @brief Checks if given future was completed
+/// @param[in] future reference to future
+/// @return true if completed, false otherwise
+bool Future_IsDone( Future future );
+
+/// @brief Waits for given future to be completed
+/// @param[in] future reference to future
+/// @param[in] milliseconds timeout (in milliseconds) for waiting (INFINITE to wait indefinitely)
+/// @return true if future got completed, false on timeout
+bool Future_Wait( Future future, unsigned int milliseconds );
+
+/// @brief Gets result of given completed future
+/// @param[in] future reference to future
+/// @return opaque pointer to produced value (NULL if future is still pending)
+void* Future_GetResult( Future future );
+
+/// @brief Chains function to be called with the result of given future, once it is completed
+/// @param[in] future reference to future
+/// @param[in] continuation pointer to the function that will receive the future result (run on the completing thread, or immediately if already completed)
+/// @return reference to new future of the continuation return value (should also be discarded)
+Future Future_Then( Future future, AsyncFunction continuation );
+
+/// @brief Waits for any future of given group to be completed
+/// @param[in] futures array of future references
+/// @param[in] count number of futures in the group
+/// @param[in] milliseconds timeout (in milliseconds) for waiting (INFINITE to wait indefinitely)
+/// @return index of a completed future in the group (FUTURE_INVALID_INDEX on timeout)
+int Future_WaitAny( Future* futures, size_t count, unsigned int milliseconds );
+
+/// @brief Waits for all futures of given group to be completed
+/// @param[in] futures array of future references
+/// @param[in] count number of futures in the group
+/// @param[in] milliseconds timeout (in milliseconds) for waiting the whole group (INFINITE to wait indefinitely)
+/// @return true if all futures got completed, false on timeout
+bool Future_WaitAll( Future* futures, size_t count, unsigned int milliseconds );
+
+#endif // THREAD_FUTURES_H
@@ -19,56 +19,748 @@
 //                                                                                  //
 //////////////////////////////////////////////////////////////////////////////////////
 
+#define _GNU_SOURCE
+
+#include "thread_atomics.h"
+
 #include "thread_locks.h"
 
+#include "threads.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef THREAD_LOCKS_NATIVE
+  #define TLOCK_BUILD_TYPE TLOCK_NATIVE
+#else
+  #define TLOCK_BUILD_TYPE TLOCK_ADAPTIVE
+#endif
+
+// Adaptive lock states
+enum { LOCK_FREE, LOCK_TAKEN, LOCK_CONTENDED };
+
+// Upper bound for spinning iterations before blocking (actual limit adapts to recent acquisitions)
+static const uint32_t MAX_SPIN_COUNT = 100;
+static const uint32_t MAX_PAUSE_COUNT = 64;
+// Fair locks spinning before blocking (ticket lock waits proportionally to its queue position)
+static const uint32_t QUEUE_SPIN_COUNT = 200;
+static const uint32_t TICKET_PAUSE_COUNT = 16;
+
+// MCS queue node states
+enum { NODE_GRANTED, NODE_WAITING, NODE_SLEEPING };
+
+// Waiting thread entry of a MCS queue lock (each waiter spins on its own cache line)
+typedef struct _QueueNode QueueNode;
+struct _QueueNode
+{
+  QueueNode* volatile next;
+  volatile uint32_t state;
+  QueueNode* nextFree;
+  uint8_t padding[ ATOMIC_CACHE_LINE_SIZE - 2 * sizeof(QueueNode*) - sizeof(uint32_t) ];
+};
+
+static void DiscardQueueNodes( QueueNode** ref_nodesList );
+
 #ifdef WIN32
 
 #include <Windows.h>
-#include <stdlib.h>
 
-// Request new unique mutex for using in thread syncronization
-TLock TLock_Create()
+typedef CRITICAL_SECTION NativeLock;
+
+static inline void InitNativeLock( NativeLock* lock ) { InitializeCriticalSection( lock ); }
+static inline void DestroyNativeLock( NativeLock* lock ) { DeleteCriticalSection( lock ); }
+static inline void AcquireNativeLock( NativeLock* lock ) { EnterCriticalSection( lock ); }
+static inline bool TryAcquireNativeLock( NativeLock* lock ) { return ( TryEnterCriticalSection( lock ) != 0 ); }
+static inline void ReleaseNativeLock( NativeLock* lock ) { LeaveCriticalSection( lock ); }
+
+// Critical sections have no timed acquisition: poll until deadline
+static bool AcquireNativeLockTimed( NativeLock* lock, uint64_t deadline )
 {
-  CRITICAL_SECTION* lock = malloc( sizeof(CRITICAL_SECTION) );
-  InitializeCriticalSection( lock );
-  return (TLock) lock;
+  while( !TryEnterCriticalSection( lock ) )
+  {
+    if( Atomic_GetTime() >= deadline ) return false;
+    Sleep( 1 );
+  }
+  return true;
 }
 
-void TLock_Discard( TLock lock )
+static inline QueueNode* AllocateQueueNode( void ) { return (QueueNode*) _aligned_malloc( sizeof(QueueNode), ATOMIC_CACHE_LINE_SIZE ); }
+static inline void FreeQueueNode( QueueNode* node ) { _aligned_free( node ); }
+
+// Fiber local storage is the only one with destructors (also called when a fiber gets deleted)
+static INIT_ONCE nodesKeyOnce = INIT_ONCE_STATIC_INIT;
+static DWORD nodesKey = FLS_OUT_OF_INDEXES;
+
+static VOID WINAPI DiscardThreadNodes( PVOID args ) { DiscardQueueNodes( (QueueNode**) args ); }
+
+static BOOL CALLBACK CreateNodesKey( PINIT_ONCE once, PVOID args, PVOID* context )
 {
-  DeleteCriticalSection( (CRITICAL_SECTION*) lock );
-  free( lock );
+  (void) once; (void) args; (void) context;
+  nodesKey = FlsAlloc( DiscardThreadNodes );
+  return TRUE;
 }
 
-// Mutex aquisition and release
-void TLock_Acquire( TLock lock ) { EnterCriticalSection( (CRITICAL_SECTION*) lock ); }
-void TLock_Release( TLock lock ) { LeaveCriticalSection( (CRITICAL_SECTION*) lock ); }
+static void SetNodesDestructor( QueueNode** ref_nodesList )
+{
+  InitOnceExecuteOnce( &nodesKeyOnce, CreateNodesKey, NULL, NULL );
+  if( nodesKey != FLS_OUT_OF_INDEXES ) FlsSetValue( nodesKey, (PVOID) ref_nodesList );
+}
 
 #else // Unix
 
 #include <pthread.h>
-#include <stdio.h>
-#include <stdlib.h>
-#include <time.h>
-#include <errno.h>
-#include <malloc.h>
+
+typedef pthread_mutex_t NativeLock;
+
+static inline void InitNativeLock( NativeLock* lock ) { pthread_mutex_init( lock, NULL ); }
+static inline void DestroyNativeLock( NativeLock* lock ) { pthread_mutex_destroy( lock ); }
+static inline void AcquireNativeLock( NativeLock* lock ) { pthread_mutex_lock( lock ); }
+static inline bool TryAcquireNativeLock( NativeLock* lock ) { return ( pthread_mutex_trylock( lock ) == 0 ); }
+static inline void ReleaseNativeLock( NativeLock* lock ) { pthread_mutex_unlock( lock ); }
+
+static bool AcquireNativeLockTimed( NativeLock* lock, uint64_t deadline )
+{
+#if defined( __GLIBC__ ) && ( __GLIBC__ > 2 || __GLIBC_MINOR__ >= 30 )
+  struct timespec timeout = { .tv_sec = (time_t) ( deadline / 1000000000 ), .tv_nsec = (long) ( deadline % 1000000000 ) };
+  return ( pthread_mutex_clocklock( lock, CLOCK_MONOTONIC, &timeout ) == 0 );
+#else
+  // Only realtime clock deadlines are available: convert the remaining time
+  struct timespec timeout;
+  clock_gettime( CLOCK_REALTIME, &timeout );
+  uint64_t now = Atomic_GetTime();
+  uint64_t remainingTime = ( deadline > now ) ? deadline - now : 0;
+  timeout.tv_sec += (time_t) ( remainingTime / 1000000000 ) + ( timeout.tv_nsec + (long) ( remainingTime % 1000000000 ) ) / 1000000000;
+  timeout.tv_nsec = ( timeout.tv_nsec + (long) ( remainingTime % 1000000000 ) ) % 1000000000;
+  return ( pthread_mutex_timedlock( lock, &timeout ) == 0 );
+#endif
+}
+
+static inline QueueNode* AllocateQueueNode( void )
+{
+  QueueNode* node = NULL;
+  if( posix_memalign( (void**) &node, ATOMIC_CACHE_LINE_SIZE, sizeof(QueueNode) ) != 0 ) return NULL;
+  return node;
+}
+
+static inline void FreeQueueNode( QueueNode* node ) { free( node ); }
+
+static pthread_once_t nodesKeyOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t nodesKey;
+static bool isNodesKeyValid = false;
+
+static void DiscardThreadNodes( void* args ) { DiscardQueueNodes( (QueueNode**) args ); }
+
+static void CreateNodesKey( void ) { isNodesKeyValid = ( pthread_key_create( &nodesKey, DiscardThreadNodes ) == 0 ); }
+
+static void SetNodesDestructor( QueueNode** ref_nodesList )
+{
+  pthread_once( &nodesKeyOnce, CreateNodesKey );
+  if( isNodesKeyValid ) pthread_setspecific( nodesKey, (void*) ref_nodesList );
+}
+
+#endif // WIN32
+
+struct _TLockData
+{
+  volatile uint32_t state;
+  volatile uint32_t spinCount;
+  enum TLockType type;
+  union
+  {
+    NativeLock nativeLock;
+    struct { volatile uint32_t nextTicket, servingTicket, waitersCount; } ticket;
+    struct { QueueNode* volatile tail; QueueNode* holderNode; } queue;
+  } data;
+#ifdef THREAD_LOCKS_PROFILING
+  TLockStats stats;
+  uint64_t holdStartTime;
+  TLock previousLock, nextLock;
+  bool isRegistered;
+#endif
+};
+
+// Fails to compile if lock data doesn't fit on storage size exposed to users
+typedef char TLockStorageSizeCheck[ ( sizeof(TLockData) <= sizeof(TLockStorage) ) ? 1 : -1 ];
+
+#ifdef THREAD_LOCKS_PROFILING
+static void RegisterLock( TLock lock );
+static void UnregisterLock( TLock lock );
+#else
+static inline void RegisterLock( TLock lock ) { (void) lock; }
+static inline void UnregisterLock( TLock lock ) { (void) lock; }
+#endif
+
 
 // Request new unique mutex for using in thread syncronization
 TLock TLock_Create()
 {
-  pthread_mutex_t* newLock = (pthread_mutex_t*) malloc( sizeof(pthread_mutex_t) );
-  pthread_mutex_init( newLock, NULL );
-  return (TLock) newLock;
+  return TLock_CreateType( TLOCK_DEFAULT );
+}
+
+TLock TLock_CreateType( enum TLockType type )
+{
+  return TLock_Init( (TLockStorage*) malloc( sizeof(TLockStorage) ), type );
 }
 
 void TLock_Discard( TLock lock )
 {
-  pthread_mutex_destroy( (pthread_mutex_t*) lock );
+  if( lock == NULL ) return;
+  
+  TLock_Destroy( lock );
   free( lock );
 }
 
-// Mutex aquisition and release
-void TLock_Acquire( TLock lock ) { pthread_mutex_lock( (pthread_mutex_t*) lock ); }
-void TLock_Release( TLock lock ) { pthread_mutex_unlock( (pthread_mutex_t*) lock ); }
+// Locks left with TLOCK_DEFAULT type (zeroed storage, from TLOCK_STATIC_INIT) behave as adaptive ones
+TLock TLock_Init( TLockStorage* storage, enum TLockType type )
+{
+  if( storage == NULL ) return NULL;
+  
+  TLock newLock = (TLock) storage;
+  memset( newLock, 0, sizeof(TLockData) );
+  newLock->type = ( type == TLOCK_DEFAULT ) ? TLOCK_BUILD_TYPE : type;
+  newLock->state = LOCK_FREE;
+  newLock->spinCount = MAX_SPIN_COUNT / 2;
+  if( newLock->type == TLOCK_NATIVE ) InitNativeLock( &(newLock->data.nativeLock) );
+  RegisterLock( newLock );
+  return newLock;
+}
 
-#endif // WIN32
+void TLock_Destroy( TLock lock )
+{
+  if( lock == NULL ) return;
+  
+  UnregisterLock( lock );
+  if( lock->type == TLOCK_NATIVE ) DestroyNativeLock( &(lock->data.nativeLock) );
+}
+
+// Spins for a bounded number of iterations (with exponential pause backoff), then blocks on lock state word.
+// Spinning limit tracks how long recent acquisitions took, so locks usually held for long waste little processor time
+static bool AcquireAdaptiveLock( TLock lock, uint64_t deadline )
+{
+  uint32_t spinLimit = __atomic_load_n( &(lock->spinCount), __ATOMIC_RELAXED ) * 2 + 10;
+  if( spinLimit > MAX_SPIN_COUNT ) spinLimit = MAX_SPIN_COUNT;
+  
+  uint32_t spinsCount = 0, pausesCount = 1;
+  for( ; spinsCount < spinLimit; spinsCount++ )
+  {
+    for( uint32_t i = 0; i < pausesCount; i++ )
+      Atomic_Pause();
+    if( pausesCount < MAX_PAUSE_COUNT ) pausesCount *= 2;
+    
+    if( __atomic_load_n( &(lock->state), __ATOMIC_RELAXED ) == LOCK_FREE )
+    {
+      uint32_t expected = LOCK_FREE;
+      if( __atomic_compare_exchange_n( &(lock->state), &expected, LOCK_TAKEN, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED ) ) break;
+    }
+  }
+  
+  // Failed spinning counts as zero, so that the limit decays for locks held for long
+  uint32_t spinCount = __atomic_load_n( &(lock->spinCount), __ATOMIC_RELAXED );
+  uint32_t sampleCount = ( spinsCount < spinLimit ) ? spinsCount : 0;
+  __atomic_store_n( &(lock->spinCount), (uint32_t) ( (int32_t) spinCount + ( (int32_t) sampleCount - (int32_t) spinCount ) / 8 ), __ATOMIC_RELAXED );
+  
+  if( spinsCount < spinLimit ) return true;
+  
+  // Give the holder a last chance (useful when it was preempted) before sleeping
+  Atomic_Yield();
+  
+  // Mark lock as contended, so that releasing thread knows it should wake someone
+  while( __atomic_exchange_n( &(lock->state), LOCK_CONTENDED, __ATOMIC_ACQUIRE ) != LOCK_FREE )
+  {
+    if( !Atomic_Wait( &(lock->state), LOCK_CONTENDED, deadline ) )
+      return ( __atomic_exchange_n( &(lock->state), LOCK_CONTENDED, __ATOMIC_ACQUIRE ) == LOCK_FREE );
+  }
+  
+  return true;
+}
+
+// Ticket lock: acquired in arrival order, with waiters backing off proportionally to their distance from the head
+static void AcquireTicketLock( TLock lock )
+{
+  uint32_t ticket = __atomic_fetch_add( &(lock->data.ticket.nextTicket), 1, __ATOMIC_RELAXED );
+  
+  uint32_t servingTicket;
+  for( uint32_t spinsCount = 0; ( servingTicket = __atomic_load_n( &(lock->data.ticket.servingTicket), __ATOMIC_ACQUIRE ) ) != ticket; spinsCount++ )
+  {
+    if( spinsCount < QUEUE_SPIN_COUNT )
+    {
+      for( uint32_t i = 0; i < ( ticket - servingTicket ) * TICKET_PAUSE_COUNT; i++ )
+        Atomic_Pause();
+      continue;
+    }
+    
+    __atomic_fetch_add( &(lock->data.ticket.waitersCount), 1, __ATOMIC_SEQ_CST );
+    while( ( servingTicket = __atomic_load_n( &(lock->data.ticket.servingTicket), __ATOMIC_SEQ_CST ) ) != ticket )
+      Atomic_Wait( &(lock->data.ticket.servingTicket), servingTicket, ATOMIC_TIME_INFINITE );
+    __atomic_fetch_sub( &(lock->data.ticket.waitersCount), 1, __ATOMIC_RELAXED );
+    break;
+  }
+}
+
+static bool TryAcquireTicketLock( TLock lock )
+{
+  uint32_t ticket = __atomic_load_n( &(lock->data.ticket.nextTicket), __ATOMIC_RELAXED );
+  if( __atomic_load_n( &(lock->data.ticket.servingTicket), __ATOMIC_ACQUIRE ) != ticket ) return false;
+  return __atomic_compare_exchange_n( &(lock->data.ticket.nextTicket), &ticket, ticket + 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED );
+}
+
+static void ReleaseTicketLock( TLock lock )
+{
+  __atomic_store_n( &(lock->data.ticket.servingTicket), lock->data.ticket.servingTicket + 1, __ATOMIC_SEQ_CST );
+  // Sleeping waiters can't know which of them is next, so all are awaken
+  if( __atomic_load_n( &(lock->data.ticket.waitersCount), __ATOMIC_SEQ_CST ) > 0 ) 
+    Atomic_Wake( &(lock->data.ticket.servingTicket), true );
+}
+
+// Queue nodes are reused by each thread, and deallocated on its exit. Releasers hand the lock over with a 
+// single exchange on the successor node, so they never read it afterwards (only its address is used for waking)
+static THREAD_LOCAL QueueNode* freeQueueNodes = NULL;
+static THREAD_LOCAL bool hasNodesDestructor = false;
+
+static void DiscardQueueNodes( QueueNode** ref_nodesList )
+{
+  while( *ref_nodesList != NULL )
+  {
+    QueueNode* node = *ref_nodesList;
+    *ref_nodesList = node->nextFree;
+    FreeQueueNode( node );
+  }
+  hasNodesDestructor = false;
+}
+
+// Returns NULL if no node could be allocated
+static QueueNode* GetQueueNode( void )
+{
+  QueueNode* node = freeQueueNodes;
+  if( node != NULL ) freeQueueNodes = node->nextFree;
+  else
+  {
+    if( !hasNodesDestructor )
+    {
+      SetNodesDestructor( &freeQueueNodes );
+      hasNodesDestructor = true;
+    }
+    if( (node = AllocateQueueNode()) == NULL ) return NULL;
+  }
+  
+  __atomic_store_n( &(node->next), NULL, __ATOMIC_RELAXED );
+  __atomic_store_n( &(node->state), NODE_WAITING, __ATOMIC_RELAXED );
+  
+  return node;
+}
+
+static void PutQueueNode( QueueNode* node )
+{
+  node->nextFree = freeQueueNodes;
+  freeQueueNodes = node;
+}
+
+// MCS lock: waiters are linked in arrival order, and each one spins (then sleeps) on its own node
+static void AcquireQueueLock( TLock lock )
+{
+  // Out of memory: wait for some to be freed, as acquisition can't fail
+  QueueNode* node = NULL;
+  while( (node = GetQueueNode()) == NULL )
+    Atomic_Yield();
+  
+  QueueNode* predecessor = __atomic_exchange_n( &(lock->data.queue.tail), node, __ATOMIC_ACQ_REL );
+  if( predecessor != NULL )
+  {
+    __atomic_store_n( &(predecessor->next), node, __ATOMIC_RELEASE );
+    
+    uint32_t spinsCount = 0;
+    while( __atomic_load_n( &(node->state), __ATOMIC_ACQUIRE ) == NODE_WAITING && spinsCount++ < QUEUE_SPIN_COUNT )
+      Atomic_Pause();
+    
+    uint32_t state = NODE_WAITING;
+    if( __atomic_compare_exchange_n( &(node->state), &state, NODE_SLEEPING, false, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE ) )
+    {
+      while( __atomic_load_n( &(node->state), __ATOMIC_ACQUIRE ) == NODE_SLEEPING )
+        Atomic_Wait( &(node->state), NODE_SLEEPING, ATOMIC_TIME_INFINITE );
+    }
+  }
+  
+  lock->data.queue.holderNode = node;
+}
+
+static bool TryAcquireQueueLock( TLock lock )
+{
+  QueueNode* node = GetQueueNode();
+  if( node == NULL ) return false;
+  
+  QueueNode* expected = NULL;
+  if( !__atomic_compare_exchange_n( &(lock->data.queue.tail), &expected, node, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED ) )
+  {
+    PutQueueNode( node );
+    return false;
+  }
+  
+  lock->data.queue.holderNode = node;
+  
+  return true;
+}
+
+static void ReleaseQueueLock( TLock lock )
+{
+  QueueNode* node = lock->data.queue.holderNode;
+  
+  QueueNode* successor = __atomic_load_n( &(node->next), __ATOMIC_ACQUIRE );
+  if( successor == NULL )
+  {
+    QueueNode* expected = node;
+    if( __atomic_compare_exchange_n( &(lock->data.queue.tail), &expected, NULL, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED ) )
+    {
+      PutQueueNode( node );
+      return;
+    }
+    // A new waiter got in the queue, but didn't link itself yet
+    while( ( successor = __atomic_load_n( &(node->next), __ATOMIC_ACQUIRE ) ) == NULL )
+      Atomic_Pause();
+  }
+  
+  // Successor may reuse (or free) its node as soon as it is granted
+  if( __atomic_exchange_n( &(successor->state), NODE_GRANTED, __ATOMIC_RELEASE ) == NODE_SLEEPING ) 
+    Atomic_Wake( &(successor->state), false );
+  
+  PutQueueNode( node );
+}
+
+// Mutex aquisition and release (without instrumentation)
+static inline bool TryAcquireLock( TLock lock )
+{
+  uint32_t expected = LOCK_FREE;
+  switch( lock->type )
+  {
+    case TLOCK_NATIVE: return TryAcquireNativeLock( &(lock->data.nativeLock) );
+    case TLOCK_TICKET: return TryAcquireTicketLock( lock );
+    case TLOCK_MCS: return TryAcquireQueueLock( lock );
+    default: return __atomic_compare_exchange_n( &(lock->state), &expected, LOCK_TAKEN, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED );
+  }
+}
+
+static inline void AcquireLock( TLock lock )
+{
+  switch( lock->type )
+  {
+    case TLOCK_NATIVE: AcquireNativeLock( &(lock->data.nativeLock) ); break;
+    case TLOCK_TICKET: AcquireTicketLock( lock ); break;
+    case TLOCK_MCS: AcquireQueueLock( lock ); break;
+    default: if( !TryAcquireLock( lock ) ) AcquireAdaptiveLock( lock, ATOMIC_TIME_INFINITE );
+  }
+}
+
+// Fair locks can't leave their queues once in: timed acquisitions poll for the lock instead
+static bool PollLock( TLock lock, uint64_t deadline )
+{
+  for( uint32_t spinsCount = 0; !TryAcquireLock( lock ); spinsCount++ )
+  {
+    if( Atomic_GetTime() >= deadline ) return false;
+    if( spinsCount < QUEUE_SPIN_COUNT ) Atomic_Pause();
+    else Atomic_Yield();
+  }
+  
+  return true;
+}
+
+static inline bool AcquireLockTimed( TLock lock, uint64_t deadline )
+{
+  if( deadline == ATOMIC_TIME_INFINITE )
+  {
+    AcquireLock( lock );
+    return true;
+  }
+  
+  switch( lock->type )
+  {
+    case TLOCK_NATIVE: return AcquireNativeLockTimed( &(lock->data.nativeLock), deadline );
+    case TLOCK_TICKET: 
+    case TLOCK_MCS: return PollLock( lock, deadline );
+    default: return ( TryAcquireLock( lock ) || AcquireAdaptiveLock( lock, deadline ) );
+  }
+}
+
+static inline void ReleaseLock( TLock lock )
+{
+  switch( lock->type )
+  {
+    case TLOCK_NATIVE: ReleaseNativeLock( &(lock->data.nativeLock) ); break;
+    case TLOCK_TICKET: ReleaseTicketLock( lock ); break;
+    case TLOCK_MCS: ReleaseQueueLock( lock ); break;
+    default: 
+      if( __atomic_exchange_n( &(lock->state), LOCK_FREE, __ATOMIC_RELEASE ) == LOCK_CONTENDED )
+        Atomic_Wake( &(lock->state), false );
+  }
+}
+
+#ifdef THREAD_LOCKS_PROFILING
+
+// Simple spinlock for the list of existing locks (it can't be a TLock itself)
+static volatile uint32_t registryLock = 0;
+static TLock profiledLocksList = NULL;
+
+static void AcquireRegistry( void )
+{
+  while( __atomic_exchange_n( &registryLock, 1, __ATOMIC_ACQUIRE ) != 0 )
+    Atomic_Yield();
+}
+
+static void ReleaseRegistry( void ) { __atomic_store_n( &registryLock, 0, __ATOMIC_RELEASE ); }
+
+static void RegisterLock( TLock lock )
+{
+  memset( &(lock->stats), 0, sizeof(TLockStats) );
+  lock->holdStartTime = 0;
+  
+  AcquireRegistry();
+  lock->previousLock = NULL;
+  lock->nextLock = profiledLocksList;
+  if( profiledLocksList != NULL ) profiledLocksList->previousLock = lock;
+  profiledLocksList = lock;
+  lock->isRegistered = true;
+  ReleaseRegistry();
+}
+
+static void UnregisterLock( TLock lock )
+{
+  if( !lock->isRegistered ) return;
+  
+  AcquireRegistry();
+  if( lock->previousLock != NULL ) lock->previousLock->nextLock = lock->nextLock;
+  else profiledLocksList = lock->nextLock;
+  if( lock->nextLock != NULL ) lock->nextLock->previousLock = lock->previousLock;
+  ReleaseRegistry();
+}
+
+// Statistics are only written by the thread holding the lock, so plain increments suffice. 
+// Stores are still atomic (relaxed) because snapshots are read concurrently
+static inline void AddStat( uint64_t* stat, uint64_t value ) { __atomic_store_n( stat, *stat + value, __ATOMIC_RELAXED ); }
+
+static inline void UpdateMaxStat( uint64_t* stat, uint64_t value ) { if( value > *stat ) __atomic_store_n( stat, value, __ATOMIC_RELAXED ); }
+
+static inline size_t GetHistogramBin( uint64_t time )
+{
+  size_t bin = 63 - (size_t) __builtin_clzll( time | 1 );
+  return ( bin < TLOCK_HISTOGRAM_BINS ) ? bin : TLOCK_HISTOGRAM_BINS - 1;
+}
+
+// Keeps the heaviest waiting threads with the "space saving" approximation: 
+// an unknown thread replaces the entry with least waiting time, inheriting its counts
+static void UpdateTopWaiters( TLock lock, uint64_t waitTime )
+{
+  unsigned long threadID = Thread_GetID();
+  TLockWaiterStats* waiters = lock->stats.topWaiters;
+  
+  size_t waiterIndex = 0;
+  for( size_t i = 0; i < TLOCK_TOP_WAITERS_COUNT; i++ )
+  {
+    if( waiters[ i ].threadID == threadID )
+    {
+      waiterIndex = i;
+      break;
+    }
+    if( waiters[ i ].waitTime < waiters[ waiterIndex ].waitTime ) waiterIndex = i;
+  }
+  
+  __atomic_store_n( &(waiters[ waiterIndex ].threadID), threadID, __ATOMIC_RELAXED );
+  AddStat( &(waiters[ waiterIndex ].contendedCount), 1 );
+  AddStat( &(waiters[ waiterIndex ].waitTime), waitTime );
+}
+
+static void RecordAcquire( TLock lock, bool isContended, uint64_t waitTime )
+{
+  AddStat( &(lock->stats.acquiresCount), 1 );
+  if( !isContended ) return;
+  
+  AddStat( &(lock->stats.contendedCount), 1 );
+  AddStat( &(lock->stats.totalWaitTime), waitTime );
+  UpdateMaxStat( &(lock->stats.maxWaitTime), waitTime );
+  AddStat( &(lock->stats.waitHistogram[ GetHistogramBin( waitTime ) ]), 1 );
+  UpdateTopWaiters( lock, waitTime );
+}
+
+void TLock_Acquire( TLock lock )
+{
+  if( TryAcquireLock( lock ) )
+  {
+    lock->holdStartTime = Atomic_GetTime();
+    RecordAcquire( lock, false, 0 );
+    return;
+  }
+  
+  uint64_t waitStartTime = Atomic_GetTime();
+  AcquireLock( lock );
+  lock->holdStartTime = Atomic_GetTime();
+  RecordAcquire( lock, true, lock->holdStartTime - waitStartTime );
+}
+
+bool TLock_AcquireTimed( TLock lock, unsigned int milliseconds )
+{
+  if( TryAcquireLock( lock ) )
+  {
+    lock->holdStartTime = Atomic_GetTime();
+    RecordAcquire( lock, false, 0 );
+    return true;
+  }
+  
+  uint64_t waitStartTime = Atomic_GetTime();
+  if( !AcquireLockTimed( lock, Atomic_GetDeadline( milliseconds ) ) ) return false;
+  lock->holdStartTime = Atomic_GetTime();
+  RecordAcquire( lock, true, lock->holdStartTime - waitStartTime );
+  
+  return true;
+}
+
+bool TLock_TryAcquire( TLock lock )
+{
+  if( !TryAcquireLock( lock ) ) return false;
+  
+  lock->holdStartTime = Atomic_GetTime();
+  RecordAcquire( lock, false, 0 );
+  
+  return true;
+}
+
+void TLock_Release( TLock lock )
+{
+  uint64_t holdTime = Atomic_GetTime() - lock->holdStartTime;
+  AddStat( &(lock->stats.totalHoldTime), holdTime );
+  UpdateMaxStat( &(lock->stats.maxHoldTime), holdTime );
+  AddStat( &(lock->stats.holdHistogram[ GetHistogramBin( holdTime ) ]), 1 );
+  
+  ReleaseLock( lock );
+}
+
+void TLock_SetName( TLock lock, const char* name )
+{
+  if( lock == NULL || name == NULL ) return;
+  
+  AcquireLock( lock );
+  strncpy( lock->stats.name, name, TLOCK_NAME_MAX_LENGTH - 1 );
+  lock->stats.name[ TLOCK_NAME_MAX_LENGTH - 1 ] = '\0';
+  ReleaseLock( lock );
+}
+
+// Snapshot is taken without locking, so counters might be slightly inconsistent among themselves
+static void CopyStats( TLock lock, TLockStats* stats )
+{
+  uint64_t* stat = (uint64_t*) &(lock->stats.acquiresCount);
+  uint64_t* statCopy = (uint64_t*) &(stats->acquiresCount);
+  size_t statsCount = ( (uint8_t*) &(lock->stats.topWaiters) - (uint8_t*) stat ) / sizeof(uint64_t);
+  for( size_t i = 0; i < statsCount; i++ )
+    statCopy[ i ] = __atomic_load_n( &(stat[ i ]), __ATOMIC_RELAXED );
+  
+  for( size_t i = 0; i < TLOCK_TOP_WAITERS_COUNT; i++ )
+  {
+    stats->topWaiters[ i ].threadID = __atomic_load_n( &(lock->stats.topWaiters[ i ].threadID), __ATOMIC_RELAXED );
+    stats->topWaiters[ i ].contendedCount = __atomic_load_n( &(lock->stats.topWaiters[ i ].contendedCount), __ATOMIC_RELAXED );
+    stats->topWaiters[ i ].waitTime = __atomic_load_n( &(lock->stats.topWaiters[ i ].waitTime), __ATOMIC_RELAXED );
+  }
+  
+  memcpy( stats->name, lock->stats.name, TLOCK_NAME_MAX_LENGTH );
+}
+
+bool TLock_GetStats( TLock lock, TLockStats* stats )
+{
+  if( lock == NULL || stats == NULL ) return false;
+  
+  CopyStats( lock, stats );
+  
+  return true;
+}
+
+void TLock_ResetStats( TLock lock )
+{
+  if( lock == NULL ) return;
+  
+  AcquireLock( lock );
+  memset( &(lock->stats.acquiresCount), 0, sizeof(TLockStats) - TLOCK_NAME_MAX_LENGTH );
+  ReleaseLock( lock );
+}
+
+// Copies statistics of all registered locks, so that they are processed without holding the registry
+static TLockStats* GetAllStats( size_t* ref_locksCount, bool isAddressNamed )
+{
+  AcquireRegistry();
+  size_t locksCount = 0;
+  for( TLock lock = profiledLocksList; lock != NULL; lock = lock->nextLock )
+    locksCount++;
+  TLockStats* statsList = (TLockStats*) malloc( ( locksCount + 1 ) * sizeof(TLockStats) );
+  locksCount = 0;
+  for( TLock lock = profiledLocksList; lock != NULL && statsList != NULL; lock = lock->nextLock )
+  {
+    CopyStats( lock, &(statsList[ locksCount ]) );
+    if( isAddressNamed && statsList[ locksCount ].name[ 0 ] == '\0' ) 
+      snprintf( statsList[ locksCount ].name, TLOCK_NAME_MAX_LENGTH, "%p", (void*) lock );
+    locksCount++;
+  }
+  ReleaseRegistry();
+  
+  *ref_locksCount = locksCount;
+  return statsList;
+}
+
+size_t TLock_ForAllStats( TLockStatsOperator statsOperator, void* context )
+{
+  size_t locksCount = 0;
+  TLockStats* statsList = GetAllStats( &locksCount, false );
+  
+  // Operator may take its time, or even create and discard locks
+  for( size_t i = 0; i < locksCount && statsOperator != NULL; i++ )
+    statsOperator( &(statsList[ i ]), context );
+  
+  free( statsList );
+  
+  return locksCount;
+}
+
+static int CompareWaitTimes( const void* ref_stats_1, const void* ref_stats_2 )
+{
+  uint64_t waitTime_1 = ((const TLockStats*) ref_stats_1)->totalWaitTime;
+  uint64_t waitTime_2 = ((const TLockStats*) ref_stats_2)->totalWaitTime;
+  return ( waitTime_1 < waitTime_2 ) - ( waitTime_1 > waitTime_2 );
+}
+
+void TLock_PrintStats( FILE* output )
+{
+  if( output == NULL ) return;
+  
+  size_t locksCount = 0;
+  TLockStats* statsList = GetAllStats( &locksCount, true );
+  
+  qsort( statsList, locksCount, sizeof(TLockStats), CompareWaitTimes );
+  
+  fprintf( output, "%-31s %12s %12s %14s %12s %14s %12s\n", "lock", "acquires", "contended", "wait total ns", "wait max ns", "hold total ns", "hold max ns" );
+  for( size_t i = 0; i < locksCount; i++ )
+  {
+    TLockStats* stats = &(statsList[ i ]);
+    if( stats->acquiresCount == 0 ) continue;
+    fprintf( output, "%-31s %12llu %12llu %14llu %12llu %14llu %12llu\n", stats->name, 
+             (unsigned long long) stats->acquiresCount, (unsigned long long) stats->contendedCount, 
+             (unsigned long long) stats->totalWaitTime, (unsigned long long) stats->maxWaitTime, 
+             (unsigned long long) stats->totalHoldTime, (unsigned long long) stats->maxHoldTime );
+    for( size_t waiterIndex = 0; waiterIndex < TLOCK_TOP_WAITERS_COUNT; waiterIndex++ )
+    {
+      if( stats->topWaiters[ waiterIndex ].threadID == 0 ) continue;
+      fprintf( output, "  waiter thread %lu: %llu waits, %llu ns\n", stats->topWaiters[ waiterIndex ].threadID, 
+               (unsigned long long) stats->topWaiters[ waiterIndex ].contendedCount, (unsigned long long) stats->topWaiters[ waiterIndex ].waitTime );
+    }
+  }
+  
+  free( statsList );
+}
+
+#else
+
+void TLock_Acquire( TLock lock ) { AcquireLock( lock ); }
+bool TLock_AcquireTimed( TLock lock, unsigned int milliseconds ) { return AcquireLockTimed( lock, Atomic_GetDeadline( milliseconds ) ); }
+bool TLock_TryAcquire( TLock lock ) { return TryAcquireLock( lock ); }
+void TLock_Release( TLock lock ) { ReleaseLock( lock ); }
+
+// Profiling disabled: statistics functions do nothing
+void TLock_SetName( TLock lock, const char* name ) { (void) lock; (void) name; }
+bool TLock_GetStats( TLock lock, TLockStats* stats ) { (void) lock; (void) stats; return false; }
+void TLock_ResetStats( TLock lock ) { (void) lock; }
+size_t TLock_ForAllStats( TLockStatsOperator statsOperator, void* context ) { (void) statsOperator; (void) context; return 0; }
+void TLock_PrintStats( FILE* output ) { (void) output; }
+
+#endif // THREAD_LOCKS_PROFILING
@@ -29,24 +29,138 @@
 #ifndef THREAD_LOCKS_H
 #define THREAD_LOCKS_H
 
-typedef void* TLock;       ///< Opaque alias for platform specific thread multiplexer (mutex) type
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+/// Lock implementations
+enum TLockType 
+{ 
+  TLOCK_DEFAULT,          ///< Build time default implementation (adaptive, unless library is built with THREAD_LOCKS_NATIVE defined)
+  TLOCK_NATIVE,           ///< Operating system mutex (pthread mutex or critical section)
+  TLOCK_ADAPTIVE,         ///< Futex based lock, spinning for a bounded (adaptive) time before blocking
+  TLOCK_TICKET,           ///< Fair (first come, first served) ticket lock, for moderate contention
+  TLOCK_MCS               ///< Fair MCS queue lock, where each waiter spins on its own cache line, for high contention on many cores
+};
+
+typedef struct _TLockData TLockData;      ///< Single lock internal data structure
+typedef TLockData* TLock;                 ///< Opaque reference to thread multiplexer (mutex) data
+
+#ifdef THREAD_LOCKS_PROFILING
+  #define TLOCK_STORAGE_SIZE 832          ///< Size (in bytes) of memory required by a single lock (with profiling data)
+#else
+  #define TLOCK_STORAGE_SIZE 64           ///< Size (in bytes) of memory required by a single lock
+#endif
+
+/// Caller provided memory (e.g. embedded on other structures) for holding a single lock
+typedef union _TLockStorage
+{
+  uint8_t bytes[ TLOCK_STORAGE_SIZE ];    ///< Raw lock data
+  uint64_t alignment;                     ///< Forces proper alignment of lock data
+  void* pointerAlignment;                 ///< Forces proper alignment of lock data
+}
+TLockStorage;
+
+#define TLOCK_STATIC_INIT { { 0 } }                       ///< Initializer for static storage of an (unlocked, adaptive) lock that doesn't require TLock_Init() call
+#define TLOCK_FROM_STORAGE( storage ) ( (TLock) (storage) )   ///< Reference to lock held on given (initialized) storage pointer
+
+#define TLOCK_NAME_MAX_LENGTH 32          ///< Maximum length (with terminating null character) of lock names
+#define TLOCK_HISTOGRAM_BINS 32           ///< Number of logarithmic time histogram bins (bin i counts durations in [2^i,2^(i+1)) nanoseconds)
+#define TLOCK_TOP_WAITERS_COUNT 4         ///< Number of threads tracked as top waiters for each lock
+
+/// Waiting statistics of a single thread on a lock
+typedef struct _TLockWaiterStats
+{
+  unsigned long threadID;                 ///< Identifier of waiting thread (0 for unused entries)
+  uint64_t contendedCount;                ///< Number of times the thread had to wait for the lock
+  uint64_t waitTime;                      ///< Total time (in nanoseconds) the thread waited for the lock
+}
+TLockWaiterStats;
+
+/// Contention statistics of a single lock (only gathered if library is built with THREAD_LOCKS_PROFILING defined)
+typedef struct _TLockStats
+{
+  char name[ TLOCK_NAME_MAX_LENGTH ];     ///< Name given with TLock_SetName() (empty if never set)
+  uint64_t acquiresCount;                 ///< Number of successful acquisitions
+  uint64_t contendedCount;                ///< Number of acquisitions that found the lock already held
+  uint64_t totalWaitTime, maxWaitTime;    ///< Accumulated and maximum waiting times (in nanoseconds) of contended acquisitions
+  uint64_t totalHoldTime, maxHoldTime;    ///< Accumulated and maximum times (in nanoseconds) between acquisitions and releases
+  uint64_t waitHistogram[ TLOCK_HISTOGRAM_BINS ];                 ///< Distribution of contended acquisitions waiting times
+  uint64_t holdHistogram[ TLOCK_HISTOGRAM_BINS ];                 ///< Distribution of holding times
+  TLockWaiterStats topWaiters[ TLOCK_TOP_WAITERS_COUNT ];         ///< Threads with longest total waiting times (approximated)
+}
+TLockStats;
+
+typedef void (*TLockStatsOperator)( const TLockStats*, void* );   ///< Signature of functions applied to statistics of all profiled locks
 
                                                                      
 /// @brief Request new unique mutex for using in thread syncronization                                                       
 /// @return newly created mutex reference
 TLock TLock_Create();
 
+/// @brief Request new unique mutex with given implementation
+/// @param[in] type lock implementation (TLOCK_DEFAULT for the same as TLock_Create())
+/// @return newly created mutex reference
+TLock TLock_CreateType( enum TLockType type );
+
 /// @brief Discards given mutex data                              
 /// @param[in] lock mutex reference
 void TLock_Discard( TLock lock );
 
+/// @brief Initializes mutex on caller provided memory, without allocations
+/// @param[in] storage pointer to lock storage (should remain valid until TLock_Destroy())
+/// @param[in] type lock implementation (TLOCK_DEFAULT for the same as TLock_Create())
+/// @return reference to mutex held on given storage (NULL on errors)
+TLock TLock_Init( TLockStorage* storage, enum TLockType type );
+
+/// @brief Releases resources of mutex initialized with TLock_Init(), leaving its storage to the caller
+/// @param[in] lock mutex reference
+void TLock_Destroy( TLock lock );
+
 /// @brief Mutex acquisition (blocks calling thread if it is already acquired in another thread)                              
 /// @param[in] lock mutex reference
 void TLock_Acquire( TLock lock );
 
+/// @brief Mutex acquisition with timeout (blocks calling thread for a limited time if it is already acquired in another thread)
+/// @param[in] lock mutex reference
+/// @param[in] milliseconds maximum time (in milliseconds, measured with monotonic clock) for waiting (INFINITE to wait indefinitely)
+/// @return true if mutex got acquired, false on timeout
+/// @note Fair locks (TLOCK_TICKET and TLOCK_MCS) poll for acquisition when timeout is finite, so waiting isn't fair in that case
+bool TLock_AcquireTimed( TLock lock, unsigned int milliseconds );
+
+/// @brief Mutex acquisition attempt (returns immediately if it is already acquired in another thread)                              
+/// @param[in] lock mutex reference
+/// @return true if mutex got acquired, false otherwise
+bool TLock_TryAcquire( TLock lock );
+
 /// @brief Mutex release (should always be done after acquiring to awake other threads locking it)                              
 /// @param[in] lock mutex reference
 void TLock_Release( TLock lock );
 
+/// @brief Sets name identifying given mutex on profiling statistics (no effect if profiling is disabled)
+/// @param[in] lock mutex reference
+/// @param[in] name null terminated string (truncated to TLOCK_NAME_MAX_LENGTH - 1 characters)
+void TLock_SetName( TLock lock, const char* name );
+
+/// @brief Copies current contention statistics of given mutex
+/// @param[in] lock mutex reference
+/// @param[out] stats pointer to statistics structure to be filled
+/// @return true on success, false if profiling is disabled (library built without THREAD_LOCKS_PROFILING)
+bool TLock_GetStats( TLock lock, TLockStats* stats );
+
+/// @brief Clears contention statistics of given mutex (name is kept)
+/// @param[in] lock mutex reference
+void TLock_ResetStats( TLock lock );
+
+/// @brief Applies function to statistics snapshots of all existing mutexes
+/// @param[in] statsOperator pointer of function to be called for each mutex (after all snapshots are taken, so it may create or discard locks)
+/// @param[in] context opaque pointer passed as statsOperator second argument
+/// @return number of visited mutexes (0 if profiling is disabled)
+size_t TLock_ForAllStats( TLockStatsOperator statsOperator, void* context );
+
+/// @brief Prints contention statistics summary of all existing mutexes (acquired ones first)
+/// @param[in] output stream to which text is written
+void TLock_PrintStats( FILE* output );
+
 
 #endif // THREAD_LOCKS_H
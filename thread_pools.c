@@ -0,0 +1,154 @@
+//////////////////////////////////////////////////////////////////////////////////////
+//                                                                                  //
+//  Copyright (c) 2016-2025 Leonardo Consoni <leonardojc@protonmail.com>            //
+//                                                                                  //
+//  This file is part of Simple Multithreading.                                     //
+//                                                                                  //
+//  Simple Multithreading is free software: you can redistribute it and/or modify   //
+//  it under the terms of the GNU Lesser General Public License as published        //
+//  by the Free Software Foundation, either version 3 of the License, or            //
+//  (at your option) any later version.                                             //
+//                                                                                  //
+//  Simple Multithreading is distributed in the hope that it will be useful,        //
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of                  //
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                    //
+//  GNU Lesser General Public License for more details.                             //
+//                                                                                  //
+//  You should have received a copy of the GNU Lesser General Public License        //
+//  along with Simple Multithreading. If not, see <http://www.gnu.org/licenses/>.   //
+//                                                                                  //
+//////////////////////////////////////////////////////////////////////////////////////
+
+#include "thread_locks.h"
+#include "semaphores.h"
+#include "thread_safe_queues.h"
+
+#include "thread_pools.h"
+
+#include <stdlib.h>
+
+// Bounds the number of threads simultaneously waiting for the pool to drain
+static const size_t MAX_DRAINERS_COUNT = 0xFFFF;
+
+typedef struct _PoolTask
+{
+  AsyncFunction function;
+  void* args;
+}
+PoolTask;
+
+struct _ThreadPoolData
+{
+  Thread* workers;
+  size_t workersCount;
+  TSQueue tasksQueue;
+  TLock stateLock;
+  size_t pendingTasksCount, drainersCount;
+  Semaphore drainSignal;
+};
+
+
+// Worker threads loop, running queued tasks until a stop (NULL function) task is received
+static void* RunWorker( void* args )
+{
+  ThreadPool pool = (ThreadPool) args;
+  PoolTask task;
+  
+  while( TSQ_Dequeue( pool->tasksQueue, &task, TSQUEUE_WAIT ) )
+  {
+    if( task.function == NULL ) break;
+    
+    task.function( task.args );
+    
+    TLock_Acquire( pool->stateLock );
+    if( --pool->pendingTasksCount == 0 )
+    {
+      for( ; pool->drainersCount > 0; pool->drainersCount-- )
+        Sem_Increment( pool->drainSignal );
+    }
+    TLock_Release( pool->stateLock );
+  }
+  
+  return NULL;
+}
+
+ThreadPool ThreadPool_Create( size_t workersCount, size_t maxPendingTasks )
+{
+  if( workersCount == 0 || maxPendingTasks == 0 ) return NULL;
+  
+  ThreadPool pool = (ThreadPool) malloc( sizeof(ThreadPoolData) );
+  
+  pool->tasksQueue = TSQ_Create( maxPendingTasks, sizeof(PoolTask) );
+  pool->stateLock = TLock_Create();
+  pool->pendingTasksCount = pool->drainersCount = 0;
+  pool->drainSignal = Sem_Create( 0, MAX_DRAINERS_COUNT );
+  
+  pool->workers = (Thread*) calloc( workersCount, sizeof(Thread) );
+  pool->workersCount = 0;
+  while( pool->workersCount < workersCount )
+  {
+    Thread worker = Thread_Start( RunWorker, (void*) pool, THREAD_JOINABLE );
+    if( worker == THREAD_INVALID_HANDLE ) break;
+    pool->workers[ pool->workersCount++ ] = worker;
+  }
+  
+  if( pool->workersCount < workersCount )
+  {
+    ThreadPool_Discard( pool );
+    return NULL;
+  }
+  
+  return pool;
+}
+
+void ThreadPool_Discard( ThreadPool pool )
+{
+  if( pool == NULL ) return;
+  
+  PoolTask stopTask = { NULL, NULL };
+  for( size_t i = 0; i < pool->workersCount; i++ )
+    TSQ_Enqueue( pool->tasksQueue, &stopTask, TSQUEUE_WAIT );
+  for( size_t i = 0; i < pool->workersCount; i++ )
+    Thread_WaitExit( pool->workers[ i ], INFINITE );
+  free( pool->workers );
+  
+  TSQ_Discard( pool->tasksQueue );
+  TLock_Discard( pool->stateLock );
+  Sem_Discard( pool->drainSignal );
+  
+  free( pool );
+}
+
+bool ThreadPool_Submit( ThreadPool pool, AsyncFunction function, void* args )
+{
+  if( pool == NULL || function == NULL ) return false;
+  
+  TLock_Acquire( pool->stateLock );
+  pool->pendingTasksCount++;
+  TLock_Release( pool->stateLock );
+  
+  PoolTask task = { function, args };
+  return TSQ_Enqueue( pool->tasksQueue, &task, TSQUEUE_WAIT );
+}
+
+void ThreadPool_Drain( ThreadPool pool )
+{
+  if( pool == NULL ) return;
+  
+  TLock_Acquire( pool->stateLock );
+  while( pool->pendingTasksCount > 0 )
+  {
+    pool->drainersCount++;
+    TLock_Release( pool->stateLock );
+    Sem_Decrement( pool->drainSignal );
+    TLock_Acquire( pool->stateLock );
+  }
+  TLock_Release( pool->stateLock );
+}
+
+size_t ThreadPool_GetWorkersCount( ThreadPool pool )
+{
+  if( pool == NULL ) return 0;
+  
+  return pool->workersCount;
+}
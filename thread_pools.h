@@ -0,0 +1,68 @@
+//////////////////////////////////////////////////////////////////////////////////////
+//                                                                                  //
+//  Copyright (c) 2016-2025 Leonardo Consoni <leonardojc@protonmail.com>             //
+//                                                                                  //
+//  This file is part of Simple Multithreading.                                     //
+//                                                                                  //
+//  Simple Multithreading is free software: you can redistribute it and/or modify   //
+//  it under the terms of the GNU Lesser General Public License as published        //
+//  by the Free Software Foundation, either version 3 of the License, or            //
+//  (at your option) any later version.                                             //
+//                                                                                  //
+//  Simple Multithreading is distributed in the hope that it will be useful,        //
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of                  //
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                    //
+//  GNU Lesser General Public License for more details.                             //
+//                                                                                  //
+//  You should have received a copy of the GNU Lesser General Public License        //
+//  along with Simple Multithreading. If not, see <http://www.gnu.org/licenses/>.   //
+//                                                                                  //
+//////////////////////////////////////////////////////////////////////////////////////
+
+
+/// @file thread_pools.h
+/// @brief Fixed size pools of reusable worker threads.
+///
+/// Persistent worker threads that run queued asynchronous functions, so that 
+/// offloading short tasks does not require spawning a new thread for each one
+
+#ifndef THREAD_POOLS_H
+#define THREAD_POOLS_H
+
+#include "threads.h"
+
+#include <stdbool.h>
+
+/// Structure holding single thread pool data
+typedef struct _ThreadPoolData ThreadPoolData;
+/// Opaque reference to thread pool data structure
+typedef ThreadPoolData* ThreadPool;
+
+                                                                            
+/// @brief Creates thread pool data structure and starts its worker threads                                               
+/// @param[in] workersCount number of persistent worker threads                                   
+/// @param[in] maxPendingTasks maximum number of submitted tasks waiting for a free worker                                           
+/// @return reference to newly created thread pool (NULL on errors)
+ThreadPool ThreadPool_Create( size_t workersCount, size_t maxPendingTasks );
+
+/// @brief Shuts down given thread pool, waiting for already submitted tasks to finish before stopping workers and deallocating its data
+/// @param[in] pool reference to thread pool
+void ThreadPool_Discard( ThreadPool pool );
+
+/// @brief Queues given function to be run by one of the pool workers (blocks calling thread if pending tasks limit is reached)
+/// @param[in] pool reference to thread pool
+/// @param[in] function pointer to the function that will run on a worker thread (its return value is ignored)
+/// @param[in] args opaque pointer to struct that will be passed as the function argument
+/// @return true on successful submission, false otherwise
+bool ThreadPool_Submit( ThreadPool pool, AsyncFunction function, void* args );
+
+/// @brief Blocks calling thread until all tasks submitted to given pool are finished
+/// @param[in] pool reference to thread pool
+void ThreadPool_Drain( ThreadPool pool );
+
+/// @brief Gets number of worker threads of given pool
+/// @param[in] pool reference to thread pool
+/// @return number of worker threads
+size_t ThreadPool_GetWorkersCount( ThreadPool pool );
+
+#endif // THREAD_POOLS_H
@@ -0,0 +1,288 @@
+//////////////////////////////////////////////////////////////////////////////////////
+//                                                                                  //
+//  Copyright (c) 2016-2025 Leonardo Consoni <leonardojc@protonmail.com>            //
+//                                                                                  //
+//  This file is part of Simple Multithreading.                                     //
+//                                                                                  //
+//  Simple Multithreading is free software: you can redistribute it and/or modify   //
+//  it under the terms of the GNU Lesser General Public License as published        //
+//  by the Free Software Foundation, either version 3 of the License, or            //
+//  (at your option) any later version.                                             //
+//                                                                                  //
+//  Simple Multithreading is distributed in the hope that it will be useful,        //
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of                  //
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                    //
+//  GNU Lesser General Public License for more details.                             //
+//                                                                                  //
+//  You should have received a copy of the GNU Lesser General Public License        //
+//  along with Simple Multithreading. If not, see <http://www.gnu.org/licenses/>.   //
+//                                                                                  //
+//////////////////////////////////////////////////////////////////////////////////////
+
+#include "thread_atomics.h"
+
+#include "thread_locks.h"
+
+#include "thread_rwlocks.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define READER_SLOTS_COUNT 16           // Reader counters spread over different cache lines (power of 2)
+
+static const size_t WRITER_SPIN_COUNT = 100;
+static const size_t READER_SPIN_COUNT = 100;
+
+typedef struct _ReaderSlot
+{
+  volatile uint32_t readersCount;
+  uint8_t padding[ ATOMIC_CACHE_LINE_SIZE - sizeof(uint32_t) ];
+}
+ReaderSlot;
+
+struct _TRWLockData
+{
+  ReaderSlot readerSlots[ READER_SLOTS_COUNT ];
+  volatile uint32_t writersCount;       // Writers holding or waiting for the lock
+  volatile uint32_t readersWaiting;     // Readers blocked by pending writers
+  volatile uint32_t drainEpoch;         // Changed whenever a reader slot gets empty while writers are pending
+  TLock writeLock;
+};
+
+struct _TSeqLockData
+{
+  volatile uint32_t sequence;
+  TLock writeLock;
+  size_t dataSize, wordsCount;
+  uint64_t data[];
+};
+
+// Each thread always increments the same slot, so readers on different cores rarely share cache lines
+static volatile uint32_t nextReaderSlot = 0;
+static THREAD_LOCAL uint32_t readerSlot = UINT32_MAX;
+
+static inline ReaderSlot* GetReaderSlot( TRWLock lock )
+{
+  if( readerSlot == UINT32_MAX ) 
+    readerSlot = __atomic_fetch_add( &nextReaderSlot, 1, __ATOMIC_RELAXED ) % READER_SLOTS_COUNT;
+  return &(lock->readerSlots[ readerSlot ]);
+}
+
+
+TRWLock TRWLock_Create()
+{
+  TRWLock newLock = NULL;
+#ifdef WIN32
+  newLock = (TRWLock) _aligned_malloc( sizeof(TRWLockData), ATOMIC_CACHE_LINE_SIZE );
+#else
+  if( posix_memalign( (void**) &newLock, ATOMIC_CACHE_LINE_SIZE, sizeof(TRWLockData) ) != 0 ) return NULL;
+#endif
+  if( newLock == NULL ) return NULL;
+  
+  memset( newLock, 0, sizeof(TRWLockData) );
+  newLock->writeLock = TLock_Create();
+  
+  return newLock;
+}
+
+void TRWLock_Discard( TRWLock lock )
+{
+  if( lock == NULL ) return;
+  
+  TLock_Discard( lock->writeLock );
+#ifdef WIN32
+  _aligned_free( lock );
+#else
+  free( lock );
+#endif
+}
+
+// Leaves reader slot, letting a draining writer know when it gets empty
+static inline void LeaveReaderSlot( TRWLock lock, ReaderSlot* slot )
+{
+  if( __atomic_sub_fetch( &(slot->readersCount), 1, __ATOMIC_SEQ_CST ) == 0 &&
+      __atomic_load_n( &(lock->writersCount), __ATOMIC_SEQ_CST ) > 0 )
+  {
+    __atomic_fetch_add( &(lock->drainEpoch), 1, __ATOMIC_SEQ_CST );
+    Atomic_Wake( &(lock->drainEpoch), true );
+  }
+}
+
+void TRWLock_AcquireRead( TRWLock lock )
+{
+  ReaderSlot* slot = GetReaderSlot( lock );
+  
+  while( true )
+  {
+    __atomic_fetch_add( &(slot->readersCount), 1, __ATOMIC_SEQ_CST );
+    if( __atomic_load_n( &(lock->writersCount), __ATOMIC_SEQ_CST ) == 0 ) return;
+    
+    // Back off while writers are pending (writer preference)
+    LeaveReaderSlot( lock, slot );
+    
+    size_t spinsCount = 0;
+    uint32_t writersCount;
+    while( ( writersCount = __atomic_load_n( &(lock->writersCount), __ATOMIC_SEQ_CST ) ) > 0 && spinsCount++ < READER_SPIN_COUNT )
+      Atomic_Pause();
+    if( writersCount == 0 ) continue;
+    
+    __atomic_fetch_add( &(lock->readersWaiting), 1, __ATOMIC_SEQ_CST );
+    while( ( writersCount = __atomic_load_n( &(lock->writersCount), __ATOMIC_SEQ_CST ) ) > 0 )
+      Atomic_Wait( &(lock->writersCount), writersCount, ATOMIC_TIME_INFINITE );
+    __atomic_fetch_sub( &(lock->readersWaiting), 1, __ATOMIC_RELAXED );
+  }
+}
+
+bool TRWLock_TryAcquireRead( TRWLock lock )
+{
+  ReaderSlot* slot = GetReaderSlot( lock );
+  
+  if( __atomic_load_n( &(lock->writersCount), __ATOMIC_RELAXED ) > 0 ) return false;
+  
+  __atomic_fetch_add( &(slot->readersCount), 1, __ATOMIC_SEQ_CST );
+  if( __atomic_load_n( &(lock->writersCount), __ATOMIC_SEQ_CST ) == 0 ) return true;
+  
+  LeaveReaderSlot( lock, slot );
+  
+  return false;
+}
+
+void TRWLock_ReleaseRead( TRWLock lock )
+{
+  LeaveReaderSlot( lock, GetReaderSlot( lock ) );
+}
+
+// Waits for all reader slots to get empty (new readers keep out while writersCount is not zero)
+static void DrainReaders( TRWLock lock )
+{
+  for( size_t slotIndex = 0; slotIndex < READER_SLOTS_COUNT; slotIndex++ )
+  {
+    ReaderSlot* slot = &(lock->readerSlots[ slotIndex ]);
+    size_t spinsCount = 0;
+    while( true )
+    {
+      uint32_t epoch = __atomic_load_n( &(lock->drainEpoch), __ATOMIC_SEQ_CST );
+      if( __atomic_load_n( &(slot->readersCount), __ATOMIC_SEQ_CST ) == 0 ) break;
+      if( spinsCount++ < WRITER_SPIN_COUNT ) Atomic_Pause();
+      else Atomic_Wait( &(lock->drainEpoch), epoch, ATOMIC_TIME_INFINITE );
+    }
+  }
+}
+
+// Lets blocked readers in, if no other writer is pending
+static void LeaveWriters( TRWLock lock )
+{
+  if( __atomic_sub_fetch( &(lock->writersCount), 1, __ATOMIC_SEQ_CST ) == 0 &&
+      __atomic_load_n( &(lock->readersWaiting), __ATOMIC_SEQ_CST ) > 0 )
+    Atomic_Wake( &(lock->writersCount), true );
+}
+
+void TRWLock_AcquireWrite( TRWLock lock )
+{
+  __atomic_fetch_add( &(lock->writersCount), 1, __ATOMIC_SEQ_CST );
+  TLock_Acquire( lock->writeLock );
+  DrainReaders( lock );
+}
+
+bool TRWLock_TryAcquireWrite( TRWLock lock )
+{
+  __atomic_fetch_add( &(lock->writersCount), 1, __ATOMIC_SEQ_CST );
+  if( TLock_TryAcquire( lock->writeLock ) )
+  {
+    size_t slotIndex = 0;
+    for( ; slotIndex < READER_SLOTS_COUNT; slotIndex++ )
+    {
+      if( __atomic_load_n( &(lock->readerSlots[ slotIndex ].readersCount), __ATOMIC_SEQ_CST ) > 0 ) break;
+    }
+    if( slotIndex == READER_SLOTS_COUNT ) return true;
+    
+    TLock_Release( lock->writeLock );
+  }
+  
+  LeaveWriters( lock );
+  
+  return false;
+}
+
+void TRWLock_ReleaseWrite( TRWLock lock )
+{
+  TLock_Release( lock->writeLock );
+  LeaveWriters( lock );
+}
+
+
+TSeqLock TSeqLock_Create( size_t dataSize )
+{
+  size_t wordsCount = ( dataSize + sizeof(uint64_t) - 1 ) / sizeof(uint64_t);
+  
+  TSeqLock newLock = (TSeqLock) calloc( 1, sizeof(TSeqLockData) + wordsCount * sizeof(uint64_t) );
+  newLock->sequence = 0;
+  newLock->writeLock = TLock_Create();
+  newLock->dataSize = dataSize;
+  newLock->wordsCount = wordsCount;
+  
+  return newLock;
+}
+
+void TSeqLock_Discard( TSeqLock lock )
+{
+  if( lock == NULL ) return;
+  
+  TLock_Discard( lock->writeLock );
+  free( lock );
+}
+
+// Value words are copied with relaxed atomic accesses, as readers may overlap with a writer (and discard what they got)
+void TSeqLock_Read( TSeqLock lock, void* dataOut )
+{
+  size_t spinsCount = 0;
+  while( true )
+  {
+    uint32_t sequence = __atomic_load_n( &(lock->sequence), __ATOMIC_ACQUIRE );
+    if( ( sequence & 1 ) == 0 )
+    {
+      uint8_t* output = (uint8_t*) dataOut;
+      size_t remainingSize = lock->dataSize;
+      for( size_t i = 0; i < lock->wordsCount; i++ )
+      {
+        uint64_t word = __atomic_load_n( &(lock->data[ i ]), __ATOMIC_RELAXED );
+        size_t copySize = ( remainingSize < sizeof(uint64_t) ) ? remainingSize : sizeof(uint64_t);
+        memcpy( output, &word, copySize );
+        output += copySize;
+        remainingSize -= copySize;
+      }
+      
+      __atomic_thread_fence( __ATOMIC_ACQUIRE );
+      if( __atomic_load_n( &(lock->sequence), __ATOMIC_RELAXED ) == sequence ) return;
+    }
+    
+    // Writer might have been preempted in the middle of an update
+    if( spinsCount++ < READER_SPIN_COUNT ) Atomic_Pause();
+    else Atomic_Yield();
+  }
+}
+
+void TSeqLock_Write( TSeqLock lock, const void* dataIn )
+{
+  TLock_Acquire( lock->writeLock );
+  
+  uint32_t sequence = lock->sequence;
+  __atomic_store_n( &(lock->sequence), sequence + 1, __ATOMIC_RELAXED );
+  __atomic_thread_fence( __ATOMIC_RELEASE );
+  
+  const uint8_t* input = (const uint8_t*) dataIn;
+  size_t remainingSize = lock->dataSize;
+  for( size_t i = 0; i < lock->wordsCount; i++ )
+  {
+    uint64_t word = 0;
+    size_t copySize = ( remainingSize < sizeof(uint64_t) ) ? remainingSize : sizeof(uint64_t);
+    memcpy( &word, input, copySize );
+    __atomic_store_n( &(lock->data[ i ]), word, __ATOMIC_RELAXED );
+    input += copySize;
+    remainingSize -= copySize;
+  }
+  
+  __atomic_store_n( &(lock->sequence), sequence + 2, __ATOMIC_RELEASE );
+  
+  TLock_Release( lock->writeLock );
+}
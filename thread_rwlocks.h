@@ -0,0 +1,102 @@
+//////////////////////////////////////////////////////////////////////////////////////
+//                                                                                  //
+//  Copyright (c) 2016-2025 Leonardo Consoni <leonardojc@protonmail.com>             //
+//                                                                                  //
+//  This file is part of Simple Multithreading.                                     //
+//                                                                                  //
+//  Simple Multithreading is free software: you can redistribute it and/or modify   //
+//  it under the terms of the GNU Lesser General Public License as published        //
+//  by the Free Software Foundation, either version 3 of the License, or            //
+//  (at your option) any later version.                                             //
+//                                                                                  //
+//  Simple Multithreading is distributed in the hope that it will be useful,        //
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of                  //
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                    //
+//  GNU Lesser General Public License for more details.                             //
+//                                                                                  //
+//  You should have received a copy of the GNU Lesser General Public License        //
+//  along with Simple Multithreading. If not, see <http://www.gnu.org/licenses/>.   //
+//                                                                                  //
+//////////////////////////////////////////////////////////////////////////////////////
+
+
+/// @file thread_rwlocks.h
+/// @brief Platform agnostic reader-writer locks and sequence locks.
+///
+/// Synchronization for data that is read much more often than written: reader-writer locks
+/// let concurrent readers proceed in parallel, and sequence locks let readers of small plain 
+/// values run without writing to shared memory at all
+
+#ifndef THREAD_RWLOCKS_H
+#define THREAD_RWLOCKS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/// Structure holding single reader-writer lock data
+typedef struct _TRWLockData TRWLockData;
+/// Opaque reference to reader-writer lock data
+typedef TRWLockData* TRWLock;
+
+/// Structure holding single sequence lock (and protected value) data
+typedef struct _TSeqLockData TSeqLockData;
+/// Opaque reference to sequence lock data
+typedef TSeqLockData* TSeqLock;
+
+
+/// @brief Request new reader-writer lock (writer preferring: pending writers block new readers)
+/// @return newly created lock reference
+TRWLock TRWLock_Create();
+
+/// @brief Discards given reader-writer lock data
+/// @param[in] lock reader-writer lock reference
+void TRWLock_Discard( TRWLock lock );
+
+/// @brief Shared acquisition (blocks calling thread while lock is acquired or requested for writing)
+/// @param[in] lock reader-writer lock reference
+/// @note Read acquisitions are not reentrant: nested ones could deadlock with a writer pending in between
+void TRWLock_AcquireRead( TRWLock lock );
+
+/// @brief Shared acquisition attempt (returns immediately if lock is acquired or requested for writing)
+/// @param[in] lock reader-writer lock reference
+/// @return true if lock got acquired for reading, false otherwise
+bool TRWLock_TryAcquireRead( TRWLock lock );
+
+/// @brief Shared release (should always be done after acquiring for reading)
+/// @param[in] lock reader-writer lock reference
+void TRWLock_ReleaseRead( TRWLock lock );
+
+/// @brief Exclusive acquisition (blocks calling thread until all readers and other writers release the lock)
+/// @param[in] lock reader-writer lock reference
+void TRWLock_AcquireWrite( TRWLock lock );
+
+/// @brief Exclusive acquisition attempt (returns immediately if lock is acquired by readers or other writers)
+/// @param[in] lock reader-writer lock reference
+/// @return true if lock got acquired for writing, false otherwise
+bool TRWLock_TryAcquireWrite( TRWLock lock );
+
+/// @brief Exclusive release (should always be done after acquiring for writing)
+/// @param[in] lock reader-writer lock reference
+void TRWLock_ReleaseWrite( TRWLock lock );
+
+/// @brief Creates new sequence lock protecting a value of given size
+/// @param[in] dataSize size (in bytes) of protected value (should be small and plain data, without pointers to owned memory)
+/// @return newly created lock reference (with zeroed value)
+TSeqLock TSeqLock_Create( size_t dataSize );
+
+/// @brief Discards given sequence lock data
+/// @param[in] lock sequence lock reference
+void TSeqLock_Discard( TSeqLock lock );
+
+/// @brief Copies protected value to given buffer, retrying while concurrent writes happen (never blocks writers)
+/// @param[in] lock sequence lock reference
+/// @param[out] dataOut opaque pointer to preallocated buffer for value
+void TSeqLock_Read( TSeqLock lock, void* dataOut );
+
+/// @brief Replaces protected value (concurrent writers are serialized)
+/// @param[in] lock sequence lock reference
+/// @param[in] dataIn opaque pointer to copied value
+void TSeqLock_Write( TSeqLock lock, const void* dataIn );
+
+
+#endif // THREAD_RWLOCKS_H
@@ -19,7 +19,7 @@
 //                                                                                  //
 //////////////////////////////////////////////////////////////////////////////////////
 
-#include "thread_locks.h"
+#include "thread_rwlocks.h"
 
 #include "thread_safe_lists.h"
 
@@ -40,7 +40,7 @@ struct _TSListData
   Item* data;
   size_t length, itemsCount, insertCount;
   size_t itemSize;
-  TLock accessLock;
+  TRWLock accessLock;
 };
 
 
@@ -56,7 +56,7 @@ TSList TSL_Create( size_t itemSize )
   list->itemsCount = list->insertCount = 0;
   list->itemSize = itemSize;
   
-  list->accessLock = TLock_Create();
+  list->accessLock = TRWLock_Create();
   
   return list;
 }
@@ -69,7 +69,7 @@ void TSL_Discard( TSList list )
         free( list->data[ dataIndex ].data );
     free( list->data );
     
-    TLock_Discard( list->accessLock );
+    TRWLock_Discard( list->accessLock );
 
     free( list );
     list = NULL;
@@ -88,7 +88,7 @@ int ListCompare( const void* ref_item_1, const void* ref_item_2 )
 
 size_t TSL_Insert( TSList list, void* dataIn )
 {
-  TLock_Acquire( list->accessLock );
+  TRWLock_AcquireWrite( list->accessLock );
   
   if( list->itemsCount + 1 > list->length )
   {
@@ -106,7 +106,7 @@ size_t TSL_Insert( TSList list, void* dataIn )
   list->insertCount++;
   list->itemsCount++;
   
-  TLock_Release( list->accessLock );
+  TRWLock_ReleaseWrite( list->accessLock );
   
   return list->insertCount;
 }
@@ -122,14 +122,17 @@ int TSL_GetIndexKey( TSList list, size_t index )
 
 bool TSL_Remove( TSList list, int key )
 {
-  TLock_Acquire( list->accessLock );
-  
-  if( list->itemsCount == 0 ) return false;
+  TRWLock_AcquireWrite( list->accessLock );
   
   Item comparisonItem = { key, NULL };
   
-  Item* foundItem = (Item*) bsearch( (void*) &comparisonItem, (void*) list->data, list->length, list->itemSize, ListCompare );
-  if( foundItem == NULL ) return false;
+  Item* foundItem = NULL;
+  if( list->itemsCount > 0 ) foundItem = (Item*) bsearch( (void*) &comparisonItem, (void*) list->data, list->length, list->itemSize, ListCompare );
+  if( foundItem == NULL ) 
+  {
+    TRWLock_ReleaseWrite( list->accessLock );
+    return false;
+  }
   
   free( foundItem->data );
   foundItem->key = 0xFFFFFFFF;
@@ -144,7 +147,7 @@ bool TSL_Remove( TSList list, int key )
     list->data = (Item*) realloc( list->data, list->length * sizeof(Item) );
   }
   
-  TLock_Release( list->accessLock );
+  TRWLock_ReleaseWrite( list->accessLock );
   
   return true;
 }
@@ -153,29 +156,43 @@ void* TSL_AcquireItem( TSList list, int key )
 {
   Item comparisonItem = { key, NULL };
   
-  TLock_Acquire( list->accessLock );
+  TRWLock_AcquireWrite( list->accessLock );
   
   Item* foundItem = (Item*) bsearch( (void*) &comparisonItem, (void*) list->data, list->length, list->itemSize, ListCompare );
-  if( foundItem == NULL ) return NULL;
+  if( foundItem == NULL ) 
+  {
+    TRWLock_ReleaseWrite( list->accessLock );
+    return NULL;
+  }
   
   return foundItem->data;
 }
 
 void TSL_ReleaseItem( TSList list )
 {
-  TLock_Release( list->accessLock );
+  TRWLock_ReleaseWrite( list->accessLock );
 }
 
+// Copies only need shared access, so concurrent readers don't block each other
 bool TSL_GetItem( TSList list, int key, void* dataOut )
 {
-  void* foundData = TSL_AcquireItem( list, key );
-  if( foundData == NULL ) return false;
+  Item comparisonItem = { key, NULL };
+  
+  TRWLock_AcquireRead( list->accessLock );
   
+  Item* foundItem = (Item*) bsearch( (void*) &comparisonItem, (void*) list->data, list->length, list->itemSize, ListCompare );
+  if( foundItem == NULL ) 
+  {
+    TRWLock_ReleaseRead( list->accessLock );
+    return false;
+  }
+  
+  void* foundData = foundItem->data;
   if( list->itemSize > sizeof(void*) ) foundData = &foundData;
     
   if( dataOut != NULL ) memcpy( dataOut, foundData, list->itemSize );
     
-  TSL_ReleaseItem( list );
+  TRWLock_ReleaseRead( list->accessLock );
   
   return true;
 }
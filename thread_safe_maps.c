@@ -22,26 +22,33 @@
 
 #include "khash.h"
 
+#include "thread_atomics.h"
 #include "thread_locks.h"
+#include "thread_rwlocks.h"
 
 #include "thread_safe_maps.h"
 
+static const size_t READ_SPIN_COUNT = 100;
 
+// Item lock and value share a single allocation
 typedef struct _MapItemData
 {
-  void* data;
-  TLock accessLock;
+  TLockStorage accessLock;            // Serializes writers (and readers falling back to locking)
+  volatile uint32_t sequence;         // Odd while a writer holds the item (sequence lock for lock-free reads)
+  uint64_t data[];                    // Value words, accessed atomically, as lock-free readers may overlap with writers
 }
 MapItemData;
 
-KHASH_MAP_INIT_INT64( RefInt, MapItemData )
+typedef MapItemData* MapItem;
+
+KHASH_MAP_INIT_INT64( RefInt, MapItem )
 
 struct _TSMapData
 {
   khash_t( RefInt )* hashTable;
   enum TSMapKeyType keyType;
   size_t itemSize;
-  TLock insertLock;
+  TRWLock tableLock;
 };
 
 
@@ -52,7 +59,7 @@ TSMap TSM_Create( enum TSMapKeyType keyType, size_t itemSize )
   newMap->hashTable = kh_init( RefInt );
   newMap->keyType = keyType;
   newMap->itemSize = itemSize;
-  newMap->insertLock = TLock_Create();
+  newMap->tableLock = TRWLock_Create();
   
   return newMap;
 }
@@ -61,20 +68,20 @@ void TSM_Discard( TSMap map )
 {
   if( map == NULL ) return;
   
-  TLock_Acquire( map->insertLock );
+  TRWLock_AcquireWrite( map->tableLock );
   for( khint_t dataIndex = kh_begin( map->hashTable ); dataIndex < kh_end( map->hashTable ); dataIndex++ )
   {
     if( kh_exist( map->hashTable, dataIndex ) )
     {
-      free( kh_value( map->hashTable, dataIndex ).data );
-      TLock_Discard( kh_value( map->hashTable, dataIndex ).accessLock );
+      TLock_Destroy( TLOCK_FROM_STORAGE( &(kh_value( map->hashTable, dataIndex )->accessLock) ) );
+      free( kh_value( map->hashTable, dataIndex ) );
       kh_del( RefInt, map->hashTable, dataIndex );
     }
   }
   kh_destroy( RefInt, map->hashTable );
-  TLock_Release( map->insertLock );
+  TRWLock_ReleaseWrite( map->tableLock );
   
-  TLock_Discard( map->insertLock );
+  TRWLock_Discard( map->tableLock );
   
   free( map );
 }
@@ -84,6 +91,62 @@ size_t TSM_GetItemsCount( TSMap map )
   return kh_size( map->hashTable );
 }
 
+static inline size_t GetWordsCount( TSMap map ) { return ( map->itemSize + sizeof(uint64_t) - 1 ) / sizeof(uint64_t); }
+
+// Exclusive item access, flagging concurrent lock-free readers to retry
+static inline void BeginItemWrite( MapItem item )
+{
+  __atomic_store_n( &(item->sequence), item->sequence + 1, __ATOMIC_RELAXED );
+  __atomic_thread_fence( __ATOMIC_RELEASE );
+}
+
+static inline void EndItemWrite( MapItem item )
+{
+  __atomic_store_n( &(item->sequence), item->sequence + 1, __ATOMIC_RELEASE );
+}
+
+static void CopyToItem( TSMap map, MapItem item, const void* dataIn )
+{
+  const uint8_t* input = (const uint8_t*) dataIn;
+  size_t remainingSize = map->itemSize;
+  for( size_t i = 0; i < GetWordsCount( map ); i++ )
+  {
+    uint64_t word = 0;
+    size_t copySize = ( remainingSize < sizeof(uint64_t) ) ? remainingSize : sizeof(uint64_t);
+    memcpy( &word, input, copySize );
+    __atomic_store_n( &(item->data[ i ]), word, __ATOMIC_RELAXED );
+    input += copySize;
+    remainingSize -= copySize;
+  }
+}
+
+static void CopyFromItem( TSMap map, MapItem item, void* dataOut )
+{
+  uint8_t* output = (uint8_t*) dataOut;
+  size_t remainingSize = map->itemSize;
+  for( size_t i = 0; i < GetWordsCount( map ); i++ )
+  {
+    uint64_t word = __atomic_load_n( &(item->data[ i ]), __ATOMIC_RELAXED );
+    size_t copySize = ( remainingSize < sizeof(uint64_t) ) ? remainingSize : sizeof(uint64_t);
+    memcpy( output, &word, copySize );
+    output += copySize;
+    remainingSize -= copySize;
+  }
+}
+
+// Looks up item of given hash with shared access to the table (concurrent lookups don't block each other)
+static MapItem FindItem( TSMap map, unsigned long hash )
+{
+  MapItem item = NULL;
+  
+  TRWLock_AcquireRead( map->tableLock );
+  khint_t index = kh_get( RefInt, map->hashTable, (khint64_t) hash );
+  if( index != kh_end( map->hashTable ) ) item = kh_value( map->hashTable, index );
+  TRWLock_ReleaseRead( map->tableLock );
+  
+  return item;
+}
+
 unsigned long TSM_SetItem( TSMap map, const void* key, void* dataIn )
 {
   unsigned long hash = 0;
@@ -92,81 +155,121 @@ unsigned long TSM_SetItem( TSMap map, const void* key, void* dataIn )
   if( map->keyType == TSMAP_INT ) hash = (unsigned long) key;
   else if( key != NULL ) hash = (unsigned long) kh_str_hash_func( key );
   
-  TLock_Acquire( map->insertLock );
-  khint_t index = kh_get( RefInt, map->hashTable, hash );
-  if( index == kh_end( map->hashTable ) ) 
+  // Updates of existing items only need shared access to the table
+  MapItem item = FindItem( map, hash );
+  
+  if( item == NULL )
   {
-    index = kh_put( RefInt, map->hashTable, hash, &insertionStatus );
-    kh_value( map->hashTable, index ).data = malloc( map->itemSize );
-    kh_value( map->hashTable, index ).accessLock = TLock_Create();
+    TRWLock_AcquireWrite( map->tableLock );
+    khint_t index = kh_put( RefInt, map->hashTable, hash, &insertionStatus );
+    if( insertionStatus > 0 )
+    {
+      kh_value( map->hashTable, index ) = (MapItem) calloc( 1, sizeof(MapItemData) + GetWordsCount( map ) * sizeof(uint64_t) );
+      TLock_Init( &(kh_value( map->hashTable, index )->accessLock), TLOCK_DEFAULT );
+    }
+    if( insertionStatus != -1 ) item = kh_value( map->hashTable, index );
+    TRWLock_ReleaseWrite( map->tableLock );
+    
+    if( insertionStatus == -1 ) return 0;
   }
-  TLock_Release( map->insertLock );
     
-  TLock_Acquire( kh_value( map->hashTable, index ).accessLock );
-  if( dataIn != NULL ) memcpy( kh_value( map->hashTable, index ).data, dataIn, map->itemSize );
-  TLock_Release( kh_value( map->hashTable, index ).accessLock );
-  
-  if( insertionStatus == -1 ) hash = 0;
-  else hash = (unsigned long) kh_key( map->hashTable, index );
+  if( dataIn != NULL )
+  {
+    TLock_Acquire( TLOCK_FROM_STORAGE( &(item->accessLock) ) );
+    BeginItemWrite( item );
+    CopyToItem( map, item, dataIn );
+    EndItemWrite( item );
+    TLock_Release( TLOCK_FROM_STORAGE( &(item->accessLock) ) );
+  }
   
   return hash;
 }
 
 bool TSM_RemoveItem( TSMap map, unsigned long hash )
 {
+  TRWLock_AcquireWrite( map->tableLock );
   khint_t index = kh_get( RefInt, map->hashTable, (khint64_t) hash );
-  if( index == kh_end( map->hashTable ) ) return false;
+  if( index == kh_end( map->hashTable ) ) 
+  {
+    TRWLock_ReleaseWrite( map->tableLock );
+    return false;
+  }
   
-  TLock_Acquire( kh_value( map->hashTable, index ).accessLock );
-  TLock_Release( kh_value( map->hashTable, index ).accessLock );
+  MapItem item = kh_value( map->hashTable, index );
+  TLock_Acquire( TLOCK_FROM_STORAGE( &(item->accessLock) ) );
+  TLock_Release( TLOCK_FROM_STORAGE( &(item->accessLock) ) );
   
-  free( kh_value( map->hashTable, index ).data );
-  TLock_Discard( kh_value( map->hashTable, index ).accessLock );
+  TLock_Destroy( TLOCK_FROM_STORAGE( &(item->accessLock) ) );
+  free( item );
   kh_del( RefInt, map->hashTable, index );
+  TRWLock_ReleaseWrite( map->tableLock );
   
   return true;
 }
 
 void* TSM_AcquireItem( TSMap map, unsigned long hash )
 {
-  TLock_Acquire( map->insertLock );
-  TLock_Release( map->insertLock );
-  
   if( map == NULL ) return NULL;
+  
+  MapItem item = FindItem( map, hash );
+  if( item == NULL ) return NULL;
+  
+  TLock_Acquire( TLOCK_FROM_STORAGE( &(item->accessLock) ) );
+  BeginItemWrite( item );
+  
+  return item->data;
+}
 
-  khint_t index = kh_get( RefInt, map->hashTable, (khint64_t) hash );
-  if( index == kh_end( map->hashTable ) ) return NULL;
+void* TSM_AcquireItemTimed( TSMap map, unsigned long hash, unsigned int milliseconds )
+{
+  if( map == NULL ) return NULL;
+  
+  MapItem item = FindItem( map, hash );
+  if( item == NULL ) return NULL;
   
-  TLock_Acquire( kh_value( map->hashTable, index ).accessLock );
+  if( !TLock_AcquireTimed( TLOCK_FROM_STORAGE( &(item->accessLock) ), milliseconds ) ) return NULL;
+  BeginItemWrite( item );
   
-  return kh_value( map->hashTable, index ).data;
+  return item->data;
 }
 
 void TSM_ReleaseItem( TSMap map, unsigned long hash )
 {
-  TLock_Acquire( map->insertLock );
-  TLock_Release( map->insertLock );
-  
   if( map == NULL ) return;
   
-  khint_t index = kh_get( RefInt, map->hashTable, (khint64_t) hash );
-  if( index == kh_end( map->hashTable ) ) return;
+  MapItem item = FindItem( map, hash );
+  if( item == NULL ) return;
   
-  TLock_Release( kh_value( map->hashTable, index ).accessLock );
+  EndItemWrite( item );
+  TLock_Release( TLOCK_FROM_STORAGE( &(item->accessLock) ) );
 }
 
 bool TSM_GetItem( TSMap map, unsigned long hash, void* dataOut )
 {
-  void* ref_data = TSM_AcquireItem( map, hash );
-  if( ref_data == NULL ) 
+  if( map == NULL ) return false;
+  
+  MapItem item = FindItem( map, hash );
+  if( item == NULL ) return false;
+  
+  if( dataOut == NULL ) return true;
+  
+  // Concurrent readers don't write to shared memory, only retrying if a writer got in the way
+  for( size_t spinsCount = 0; spinsCount < READ_SPIN_COUNT; spinsCount++ )
   {
-    TSM_ReleaseItem( map, hash );
-    return false;
+    uint32_t sequence = __atomic_load_n( &(item->sequence), __ATOMIC_ACQUIRE );
+    if( ( sequence & 1 ) == 0 )
+    {
+      CopyFromItem( map, item, dataOut );
+      __atomic_thread_fence( __ATOMIC_ACQUIRE );
+      if( __atomic_load_n( &(item->sequence), __ATOMIC_RELAXED ) == sequence ) return true;
+    }
+    Atomic_Pause();
   }
   
-  if( dataOut != NULL ) memcpy( dataOut, ref_data, map->itemSize );
-  
-  TSM_ReleaseItem( map, hash );
+  // Item held for a long time (e.g. with TSM_AcquireItem()): wait for the writer instead of spinning
+  TLock_Acquire( TLOCK_FROM_STORAGE( &(item->accessLock) ) );
+  CopyFromItem( map, item, dataOut );
+  TLock_Release( TLOCK_FROM_STORAGE( &(item->accessLock) ) );
   
   return true;
 }
@@ -175,12 +278,19 @@ void TSM_RunForAllKeys( TSMap map, void (*objectOperator)( unsigned long ) )
 {
   if( map == NULL ) return;
   
+  // Operator is called on a snapshot of keys, so that it may change the map
+  TRWLock_AcquireRead( map->tableLock );
+  size_t keysCount = 0;
+  unsigned long* keysList = (unsigned long*) malloc( ( kh_size( map->hashTable ) + 1 ) * sizeof(unsigned long) );
   for( khint_t dataIndex = kh_begin( map->hashTable ); dataIndex < kh_end( map->hashTable ); dataIndex++ )
   {
     if( kh_exist( map->hashTable, dataIndex ) )
-      objectOperator( kh_key( map->hashTable, dataIndex ) );
-    
-    TLock_Acquire( map->insertLock );
-    TLock_Release( map->insertLock );
+      keysList[ keysCount++ ] = (unsigned long) kh_key( map->hashTable, dataIndex );
   }
+  TRWLock_ReleaseRead( map->tableLock );
+  
+  for( size_t keyIndex = 0; keyIndex < keysCount; keyIndex++ )
+    objectOperator( keysList[ keyIndex ] );
+  
+  free( keysList );
 }
@@ -78,12 +78,19 @@ bool TSM_RemoveItem( TSMap map, unsigned long hash );
 /// @param[in] hash identifier of acquired item  
 void* TSM_AcquireItem( TSMap map, unsigned long hash );
 
+/// @brief Gets direct reference to value of given item, waiting a limited time for locking its access (should be unlocked afterwards)                              
+/// @param[in] map reference to map
+/// @param[in] hash identifier of acquired item  
+/// @param[in] milliseconds maximum time (in milliseconds, measured with monotonic clock) for waiting (INFINITE to wait indefinitely)
+/// @return pointer to item value (NULL if not found or on timeout)
+void* TSM_AcquireItemTimed( TSMap map, unsigned long hash, unsigned int milliseconds );
+
 /// @brief Unlocks access for given item                           
 /// @param[in] map reference to map
 /// @param[in] hash identifier of released item 
 void TSM_ReleaseItem( TSMap map, unsigned long hash );
 
-/// @brief Copies item of specified hash identifier from thread safe list to given buffer                              
+/// @brief Copies item of specified hash identifier from thread safe list to given buffer (concurrent copies don't block each other, only waiting for writers)
 /// @param[in] map reference to map
 /// @param[in] hash identifier of copied item 
 /// @param[out] dataOut opaque pointer to preallocated buffer for variable
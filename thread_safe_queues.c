@@ -20,40 +20,248 @@
 //////////////////////////////////////////////////////////////////////////////////////
 
 
+#include "thread_atomics.h"
+
 #include "thread_locks.h"
 #include "semaphores.h"
+#include "thread_events.h"
 
 #include "thread_safe_queues.h"
 
 #include <string.h>
 #include <stdlib.h>
+#include <stddef.h>
+
+#ifdef WIN32
+#include <malloc.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+  #ifdef __linux__
+  #include <sys/eventfd.h>
+  #endif
+#endif
+
+// Slabs from this size on get backed by huge pages where available, reducing TLB misses when traversing the ring
+#define HUGE_PAGE_SIZE ( 2 * 1024 * 1024 )
+
+// Bounds the number of threads simultaneously blocked on the same queue
+static const size_t MAX_WAITERS_COUNT = 0xFFFF;
+// Bounds the attempts to overwrite the oldest item of a full lock-free queue while it's being read
+static const size_t OVERWRITE_SPIN_COUNT = 100;
+// Bounds the number of emptied segments kept by unbounded queues for reuse, so memory shrinks back after backlogs
+static const size_t MAX_FREE_SEGMENTS_COUNT = 2;
+// Marks that no slot of a single producer/consumer queue is being read in place
+static const size_t NO_POSITION = SIZE_MAX;
+
+// Multiple producer/consumer queues track slots state with its sequence number: equal to a position when free for writing it, 
+// and to the position plus one when holding its item. Each side then only reads its own index and the touched slot
+typedef struct _QueueSlot
+{
+  volatile size_t sequence;
+  uint8_t data[];
+}
+QueueSlot;
+
+// Unbounded queues chain segments holding a fixed number of slots, starting on the cache line after this header
+typedef struct _QueueSegment
+{
+  struct _QueueSegment* next;
+  size_t firstPosition;
+  bool isMapped;
+}
+QueueSegment;
 
+#define SEGMENT_HEADER_SIZE ATOMIC_CACHE_LINE_SIZE
 
 struct _TSQueueData
 {
-  void** cache;
-  size_t first, last, maxLength;
+  enum TSQueueType type;
+  uint8_t* slots;                       // Single slab of slots, each one starting on its own cache line
+  size_t slotStride, slabSize;
+  bool isSlabMapped;
+  QueueSegment* readSegment;            // Segments holding read and write positions, for unbounded queues
+  QueueSegment* writeSegment;
+  QueueSegment* freeSegmentsList;
+  size_t freeSegmentsCount;
+  size_t capacity;                      // Power of two number of slots (per segment, for unbounded queues), for indexing by mask
+  size_t maxLength;                     // Items limit (same as capacity, except for locked and unbounded queues)
   size_t itemSize;
   TLock accessLock;
-  Semaphore countLock;
+  size_t readersWaiting, writersWaiting;
+  Semaphore readSignal, writeSignal;
+  TEventCount itemsEvent, spaceEvent;
+  TEventCount setEvent;                 // Shared by all queues of the set this one belongs to, if any
+  volatile int eventDescriptor;         // Pollable descriptor, readable while queue has items (created on request)
+  volatile bool isEventSignaled;
+  TLockStorage accessLockStorage;
+  SemaphoreStorage readSignalStorage, writeSignalStorage;
+  // Read (first) and write (last) positions are kept on different cache lines. Locked queues also
+  // update them with atomic stores, as items count is read without locking. Single producer/consumer queues 
+  // keep on each line the owner side copy of the opposite position, and the slot read in place by the consumer
+  uint8_t firstPadding[ ATOMIC_CACHE_LINE_SIZE ];
+  volatile size_t first;
+  size_t cachedLast;
+  volatile size_t pinnedPosition;
+  uint8_t lastPadding[ ATOMIC_CACHE_LINE_SIZE - 3 * sizeof(size_t) ];
+  volatile size_t last;
+  size_t cachedFirst;
+  uint8_t discardPadding[ ATOMIC_CACHE_LINE_SIZE - 2 * sizeof(size_t) ];
+  volatile size_t discardPosition;      // Items before it were dropped by a single producer overwriting a full queue
+  uint8_t notifiersPadding[ ATOMIC_CACHE_LINE_SIZE - sizeof(size_t) ];
+  volatile size_t setNotifiersCount;    // Insertions possibly using the set event, waited for before unlinking it
+  uint8_t endPadding[ ATOMIC_CACHE_LINE_SIZE - sizeof(size_t) ];
+};
+
+struct _TSQueueSetData
+{
+  TSQueue* queuesList;
+  size_t queuesCount;
+  TLock accessLock;
+  TEventCount event;
 };
 
 
 TSQueue TSQ_Create( size_t maxLength, size_t itemSize )
 {
+  return TSQ_CreateType( maxLength, itemSize, TSQUEUE_LOCKED );
+}
+
+static uint8_t* AllocateSlab( size_t size, bool* outIsMapped )
+{
+  *outIsMapped = false;
+  void* slab = NULL;
+#ifdef WIN32
+  slab = _aligned_malloc( size, ATOMIC_CACHE_LINE_SIZE );
+#else
+  if( size >= HUGE_PAGE_SIZE )
+  {
+    // Explicit huge pages need to be reserved by the system: fall back to transparent ones otherwise
+  #ifdef MAP_HUGETLB
+    slab = mmap( NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0 );
+  #else
+    slab = MAP_FAILED;
+  #endif
+    if( slab == MAP_FAILED ) 
+    {
+      slab = mmap( NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+  #ifdef MADV_HUGEPAGE
+      if( slab != MAP_FAILED ) madvise( slab, size, MADV_HUGEPAGE );
+  #endif
+    }
+    if( slab != MAP_FAILED ) 
+    {
+      *outIsMapped = true;
+      return (uint8_t*) slab;
+    }
+    slab = NULL;
+  }
+  if( posix_memalign( &slab, ATOMIC_CACHE_LINE_SIZE, size ) != 0 ) return NULL;
+#endif
+  return (uint8_t*) slab;
+}
+
+static void FreeSlab( uint8_t* slab, size_t size, bool isMapped )
+{
+#ifdef WIN32
+  (void) size; (void) isMapped;
+  _aligned_free( slab );
+#else
+  if( isMapped ) munmap( slab, size );
+  else free( slab );
+#endif
+}
+
+static inline bool IsLockFree( TSQueue queue )
+{
+  return ( queue->type == TSQUEUE_SPSC || queue->type == TSQUEUE_MPMC );
+}
+
+static QueueSegment* AllocateSegment( TSQueue queue, size_t firstPosition )
+{
+  QueueSegment* segment = queue->freeSegmentsList;
+  if( segment != NULL )
+  {
+    queue->freeSegmentsList = segment->next;
+    queue->freeSegmentsCount--;
+  }
+  else
+  {
+    bool isMapped;
+    segment = (QueueSegment*) AllocateSlab( queue->slabSize, &isMapped );
+    if( segment == NULL ) return NULL;
+    segment->isMapped = isMapped;
+  }
+  segment->next = NULL;
+  segment->firstPosition = firstPosition;
+  
+  return segment;
+}
+
+static void RecycleSegment( TSQueue queue, QueueSegment* segment )
+{
+  if( queue->freeSegmentsCount >= MAX_FREE_SEGMENTS_COUNT ) 
+  {
+    FreeSlab( (uint8_t*) segment, queue->slabSize, segment->isMapped );
+    return;
+  }
+  segment->next = queue->freeSegmentsList;
+  queue->freeSegmentsList = segment;
+  queue->freeSegmentsCount++;
+}
+
+TSQueue TSQ_CreateType( size_t maxLength, size_t itemSize, enum TSQueueType type )
+{
+  if( maxLength == 0 ) return NULL;
+  
   TSQueue queue = (TSQueue) malloc( sizeof(TSQueueData) );
   
-  queue->maxLength = maxLength;
+  queue->type = type;
   queue->itemSize = itemSize;
   
-  queue->cache = (void**) calloc( queue->maxLength, sizeof(void*) );
-  for( size_t i = 0; i < queue->maxLength; i++ )
-    queue->cache[ i ] = (void*) malloc( itemSize );
+  queue->capacity = 1;
+  while( queue->capacity < maxLength ) queue->capacity <<= 1;
+  // Lock-free queues detect full state by slot sequences, so all slots are usable
+  queue->maxLength = ( type == TSQUEUE_LOCKED ) ? maxLength : queue->capacity;
+  if( type == TSQUEUE_UNBOUNDED ) queue->maxLength = SIZE_MAX;
+  
+  queue->slotStride = ( sizeof(QueueSlot) + itemSize + ATOMIC_CACHE_LINE_SIZE - 1 ) & ~( (size_t) ATOMIC_CACHE_LINE_SIZE - 1 );
+  queue->slabSize = queue->capacity * queue->slotStride;
+  if( type == TSQUEUE_UNBOUNDED ) queue->slabSize += SEGMENT_HEADER_SIZE;
+  if( queue->slabSize >= HUGE_PAGE_SIZE ) queue->slabSize = ( queue->slabSize + HUGE_PAGE_SIZE - 1 ) & ~( (size_t) HUGE_PAGE_SIZE - 1 );
+  
+  queue->slots = NULL;
+  queue->freeSegmentsList = NULL;
+  queue->freeSegmentsCount = 0;
+  queue->readSegment = queue->writeSegment = NULL;
+  if( type == TSQUEUE_UNBOUNDED ) 
+    queue->readSegment = queue->writeSegment = AllocateSegment( queue, 0 );
+  else
+    queue->slots = AllocateSlab( queue->slabSize, &(queue->isSlabMapped) );
+  if( queue->slots == NULL && queue->readSegment == NULL )
+  {
+    free( queue );
+    return NULL;
+  }
+  for( size_t i = 0; i < queue->capacity && queue->slots != NULL; i++ )
+    ( (QueueSlot*) ( queue->slots + i * queue->slotStride ) )->sequence = i;
   
   queue->first = queue->last = 0;
+  queue->cachedFirst = queue->cachedLast = 0;
+  queue->discardPosition = 0;
+  queue->pinnedPosition = NO_POSITION;
+  
+  queue->accessLock = TLock_Init( &(queue->accessLockStorage), TLOCK_DEFAULT );
+  queue->readersWaiting = queue->writersWaiting = 0;
+  queue->readSignal = Sem_Init( &(queue->readSignalStorage), 0, MAX_WAITERS_COUNT );
+  queue->writeSignal = Sem_Init( &(queue->writeSignalStorage), 0, MAX_WAITERS_COUNT );
   
-  queue->accessLock = TLock_Create();
-  queue->countLock = Sem_Create( 0, queue->maxLength );
+  queue->itemsEvent = IsLockFree( queue ) ? TEventCount_Create() : NULL;
+  queue->spaceEvent = IsLockFree( queue ) ? TEventCount_Create() : NULL;
+  queue->setEvent = NULL;
+  queue->setNotifiersCount = 0;
+  queue->eventDescriptor = -1;
+  queue->isEventSignaled = false;
   
   return queue;
 }
@@ -62,12 +270,31 @@ void TSQ_Discard( TSQueue queue )
 {
   if( queue != NULL )
   {
-    for( size_t i = 0; i < queue->maxLength; i++ )
-      free( queue->cache[ i ] );
-    free( queue->cache );
+    if( queue->slots != NULL ) FreeSlab( queue->slots, queue->slabSize, queue->isSlabMapped );
     
-    TLock_Discard( queue->accessLock );
-    Sem_Discard( queue->countLock );
+    QueueSegment* segment = queue->readSegment;
+    while( segment != NULL )
+    {
+      QueueSegment* nextSegment = segment->next;
+      FreeSlab( (uint8_t*) segment, queue->slabSize, segment->isMapped );
+      segment = nextSegment;
+    }
+    segment = queue->freeSegmentsList;
+    while( segment != NULL )
+    {
+      QueueSegment* nextSegment = segment->next;
+      FreeSlab( (uint8_t*) segment, queue->slabSize, segment->isMapped );
+      segment = nextSegment;
+    }
+    
+    TLock_Destroy( queue->accessLock );
+    Sem_Destroy( queue->readSignal );
+    Sem_Destroy( queue->writeSignal );
+    TEventCount_Discard( queue->itemsEvent );
+    TEventCount_Discard( queue->spaceEvent );
+#ifndef WIN32
+    if( queue->eventDescriptor >= 0 ) close( queue->eventDescriptor );
+#endif
 
     free( queue );
     queue = NULL;
@@ -76,44 +303,784 @@ void TSQ_Discard( TSQueue queue )
 
 size_t TSQ_GetItemsCount( TSQueue queue )
 {
-  return ( queue->last - queue->first );
+  size_t first = __atomic_load_n( &(queue->first), __ATOMIC_ACQUIRE );
+  size_t discardPosition = __atomic_load_n( &(queue->discardPosition), __ATOMIC_RELAXED );
+  if( discardPosition > first ) first = discardPosition;
+  size_t last = __atomic_load_n( &(queue->last), __ATOMIC_ACQUIRE );
+  // Lock-free readers may claim an item before the writer updates its position
+  return ( last > first ) ? ( last - first ) : 0;
 }
 
-bool TSQ_Enqueue( TSQueue queue, void* buffer, enum TSQueueAccessMode mode )
+// Blocks caller until signaled by the opposite queue end or deadline is reached (access lock should be held, and will be held again on return)
+static inline bool WaitSignal( TSQueue queue, size_t* waitersCount, Semaphore signal, uint64_t deadline )
+{
+  (*waitersCount)++;
+  TLock_Release( queue->accessLock );
+  bool isSignaled = Sem_DecrementTimed( signal, Atomic_GetTimeout( deadline ) );
+  TLock_Acquire( queue->accessLock );
+  // A signal might have been posted after timeout: consume it, otherwise stop being counted as waiter
+  if( !isSignaled && !Sem_TryDecrement( signal ) ) (*waitersCount)--;
+  
+  return isSignaled;
+}
+
+// Awakes up to given number of threads blocked on the opposite queue end, if any (access lock should be held)
+static inline void PostSignal( size_t* waitersCount, Semaphore signal, size_t count )
+{
+  if( count > *waitersCount ) count = *waitersCount;
+  if( count > 0 )
+  {
+    (*waitersCount) -= count;
+    Sem_IncrementBy( signal, count );
+  }
+}
+
+// Makes event descriptor of given queue readable. Only the first insertion after it gets reset issues a system call
+static inline void SignalEvent( TSQueue queue, int descriptor )
+{
+  if( __atomic_load_n( &(queue->isEventSignaled), __ATOMIC_RELAXED ) ) return;
+  if( __atomic_exchange_n( &(queue->isEventSignaled), true, __ATOMIC_SEQ_CST ) ) return;
+#ifndef WIN32
+  uint64_t increment = 1;
+  if( write( descriptor, &increment, sizeof(uint64_t) ) < 0 ) return;
+#else
+  (void) descriptor;
+#endif
+}
+
+// Makes event descriptor of given queue not readable, after a read finds it empty. It's drained even if not flagged 
+// as signaled, as a late signal from a racing insertion could be left behind
+static void ResetEvent( TSQueue queue )
+{
+  int descriptor = __atomic_load_n( &(queue->eventDescriptor), __ATOMIC_ACQUIRE );
+  if( descriptor < 0 ) return;
+#ifndef WIN32
+  uint64_t count;
+  if( read( descriptor, &count, sizeof(uint64_t) ) < 0 ) count = 0;
+#endif
+  __atomic_store_n( &(queue->isEventSignaled), false, __ATOMIC_RELAXED );
+  // Items inserted while resetting would have not signaled again
+  __atomic_thread_fence( __ATOMIC_SEQ_CST );
+  if( TSQ_GetItemsCount( queue ) > 0 ) SignalEvent( queue, descriptor );
+}
+
+// Lets threads waiting on the set or event descriptor of given queue know that it got new items. 
+// Insertion should be ordered before by a full memory fence, as they might get registered at the same time.
+// Set event is only used after counting the caller as notifier, so that it doesn't get discarded meanwhile
+static inline void NotifyWatchers( TSQueue queue )
 {
-  static void* dataIn = NULL;
+  if( __atomic_load_n( &(queue->setEvent), __ATOMIC_RELAXED ) != NULL )
+  {
+    __atomic_add_fetch( &(queue->setNotifiersCount), 1, __ATOMIC_SEQ_CST );
+    TEventCount setEvent = __atomic_load_n( &(queue->setEvent), __ATOMIC_SEQ_CST );
+    if( setEvent != NULL ) TEventCount_Notify( setEvent );
+    __atomic_sub_fetch( &(queue->setNotifiersCount), 1, __ATOMIC_RELEASE );
+  }
+  int descriptor = __atomic_load_n( &(queue->eventDescriptor), __ATOMIC_RELAXED );
+  if( descriptor >= 0 ) SignalEvent( queue, descriptor );
+}
+
+static inline QueueSlot* GetSlot( TSQueue queue, size_t position )
+{
+  return (QueueSlot*) ( queue->slots + ( position & ( queue->capacity - 1 ) ) * queue->slotStride );
+}
+
+// Locked queues only access the slots at read and write positions (access lock should be held).
+// Unbounded ones link a new segment when the write position passes the end of the last one (NULL is returned if it can't be allocated)
+static QueueSlot* GetWriteSlotLocked( TSQueue queue )
+{
+  if( queue->type != TSQUEUE_UNBOUNDED ) return GetSlot( queue, queue->last );
+  
+  QueueSegment* segment = queue->writeSegment;
+  if( queue->last - segment->firstPosition >= queue->capacity )
+  {
+    QueueSegment* nextSegment = AllocateSegment( queue, queue->last );
+    if( nextSegment == NULL ) return NULL;
+    segment->next = nextSegment;
+    segment = queue->writeSegment = nextSegment;
+  }
+  
+  return (QueueSlot*) ( (uint8_t*) segment + SEGMENT_HEADER_SIZE + ( queue->last & ( queue->capacity - 1 ) ) * queue->slotStride );
+}
 
-  if( buffer == NULL ) return false;
+// Unbounded queues recycle the first segment when the read position passes its end
+static QueueSlot* GetReadSlotLocked( TSQueue queue )
+{
+  if( queue->type != TSQUEUE_UNBOUNDED ) return GetSlot( queue, queue->first );
   
-  if( mode == TSQUEUE_WAIT || TSQ_GetItemsCount( queue ) < queue->maxLength ) 
-    Sem_Increment( queue->countLock );
+  QueueSegment* segment = queue->readSegment;
+  if( queue->first - segment->firstPosition >= queue->capacity )
+  {
+    queue->readSegment = segment->next;
+    RecycleSegment( queue, segment );
+    segment = queue->readSegment;
+  }
   
+  return (QueueSlot*) ( (uint8_t*) segment + SEGMENT_HEADER_SIZE + ( queue->first & ( queue->capacity - 1 ) ) * queue->slotStride );
+}
+
+// Full queue is overwritten on TSQUEUE_NOWAIT mode. Otherwise, insertion waits for space and stops when queue gets full, 
+// failing if deadline is reached before any item fits
+static size_t EnqueueLocked( TSQueue queue, uint8_t* items, size_t count, enum TSQueueAccessMode mode, uint64_t deadline )
+{
+  TLock_Acquire( queue->accessLock );
+  if( mode == TSQUEUE_WAIT )
+  {
+    while( queue->last - queue->first >= queue->maxLength )
+    {
+      if( !WaitSignal( queue, &(queue->writersWaiting), queue->writeSignal, deadline ) )
+      {
+        if( queue->last - queue->first < queue->maxLength ) break;
+        TLock_Release( queue->accessLock );
+        return 0;
+      }
+    }
+    size_t freeCount = queue->maxLength - ( queue->last - queue->first );
+    if( count > freeCount ) count = freeCount;
+  }
+  size_t insertedCount = 0;
+  for( ; insertedCount < count; insertedCount++ )
+  {
+    // Unbounded queues stop inserting when out of memory
+    QueueSlot* slot = GetWriteSlotLocked( queue );
+    if( slot == NULL ) break;
+    memcpy( slot->data, items + insertedCount * queue->itemSize, queue->itemSize );
+    if( queue->last - queue->first == queue->maxLength ) __atomic_store_n( &(queue->first), queue->first + 1, __ATOMIC_RELAXED );
+    __atomic_store_n( &(queue->last), queue->last + 1, __ATOMIC_RELAXED );
+  }
+  PostSignal( &(queue->readersWaiting), queue->readSignal, insertedCount );
+  TLock_Release( queue->accessLock );
+  __atomic_thread_fence( __ATOMIC_SEQ_CST );
+  NotifyWatchers( queue );
+
+  return insertedCount;
+}
+
+static size_t DequeueLocked( TSQueue queue, uint8_t* buffer, size_t maxCount, enum TSQueueAccessMode mode, uint64_t deadline )
+{
   TLock_Acquire( queue->accessLock );
-  dataIn = queue->cache[ queue->last % queue->maxLength ];
-  memcpy( dataIn, buffer, queue->itemSize );
-  if( TSQ_GetItemsCount( queue ) == queue->maxLength ) queue->first++;
-  queue->last++;
+  while( queue->last == queue->first )
+  {
+    if( mode == TSQUEUE_NOWAIT || !WaitSignal( queue, &(queue->readersWaiting), queue->readSignal, deadline ) )
+    {
+      if( queue->last > queue->first ) break;
+      TLock_Release( queue->accessLock );
+      return 0;
+    }
+  }
+  size_t count = queue->last - queue->first;
+  if( count > maxCount ) count = maxCount;
+  for( size_t i = 0; i < count; i++ )
+  {
+    memcpy( buffer + i * queue->itemSize, GetReadSlotLocked( queue )->data, queue->itemSize );
+    __atomic_store_n( &(queue->first), queue->first + 1, __ATOMIC_RELAXED );
+  }
+  PostSignal( &(queue->writersWaiting), queue->writeSignal, count );
   TLock_Release( queue->accessLock );
+  
+  return count;
+}
+
+// Single producer/consumer queues only exchange read and write positions, each side reloading the opposite one only when 
+// its own copy runs out of items or space, and publishing its own after copying. Slots are copied word by word, as the 
+// producer overwriting a full queue might write the oldest ones while they get read
+static void CopyToSlot( QueueSlot* slot, const uint8_t* item, size_t itemSize )
+{
+  size_t* words = (size_t*) slot->data;
+  size_t wordsCount = itemSize / sizeof(size_t);
+  for( size_t i = 0; i < wordsCount; i++ )
+  {
+    size_t word;
+    memcpy( &word, item + i * sizeof(size_t), sizeof(size_t) );
+    __atomic_store_n( &(words[ i ]), word, __ATOMIC_RELAXED );
+  }
+  for( size_t i = wordsCount * sizeof(size_t); i < itemSize; i++ )
+    __atomic_store_n( &(slot->data[ i ]), item[ i ], __ATOMIC_RELAXED );
+}
+
+static void CopyFromSlot( uint8_t* item, QueueSlot* slot, size_t itemSize )
+{
+  size_t* words = (size_t*) slot->data;
+  size_t wordsCount = itemSize / sizeof(size_t);
+  for( size_t i = 0; i < wordsCount; i++ )
+  {
+    size_t word = __atomic_load_n( &(words[ i ]), __ATOMIC_RELAXED );
+    memcpy( item + i * sizeof(size_t), &word, sizeof(size_t) );
+  }
+  for( size_t i = wordsCount * sizeof(size_t); i < itemSize; i++ )
+    item[ i ] = __atomic_load_n( &(slot->data[ i ]), __ATOMIC_RELAXED );
+}
+
+// Oldest item position of a single producer/consumer queue, skipping the ones dropped by overwriting
+static inline size_t GetOldestPosition( size_t first, size_t discardPosition )
+{
+  return ( (intptr_t) ( discardPosition - first ) > 0 ) ? discardPosition : first;
+}
+
+// Finds up to given number of oldest items of a single producer/consumer queue, without taking them
+static size_t ClaimReadSlotsSPSC( TSQueue queue, size_t maxCount, size_t* outPosition )
+{
+  size_t position = GetOldestPosition( queue->first, __atomic_load_n( &(queue->discardPosition), __ATOMIC_RELAXED ) );
+  if( (intptr_t) ( queue->cachedLast - position ) < (intptr_t) maxCount )
+    queue->cachedLast = __atomic_load_n( &(queue->last), __ATOMIC_ACQUIRE );
+  intptr_t count = (intptr_t) ( queue->cachedLast - position );
+  if( count <= 0 ) return 0;
+  
+  *outPosition = position;
+  return ( (size_t) count < maxCount ) ? (size_t) count : maxCount;
+}
 
+// Takes copied items of a single producer/consumer queue, unless the producer dropped them meanwhile, 
+// as their slots could have been overwritten during the copy (checked after it, by the fence)
+static bool ReleaseReadSlotsSPSC( TSQueue queue, size_t position, size_t count )
+{
+  __atomic_thread_fence( __ATOMIC_ACQUIRE );
+  if( (intptr_t) ( __atomic_load_n( &(queue->discardPosition), __ATOMIC_RELAXED ) - position ) > 0 ) return false;
+  __atomic_store_n( &(queue->first), position + count, __ATOMIC_RELEASE );
+  
   return true;
 }
 
-bool TSQ_Dequeue( TSQueue queue, void* buffer, enum TSQueueAccessMode mode )
+// Keeps the producer from overwriting the slot read in place at given position, failing if it was already dropped.
+// Pinning and dropping are both followed by full fences, so at least one side sees the other
+static bool PinReadSlotSPSC( TSQueue queue, size_t position )
+{
+  __atomic_store_n( &(queue->pinnedPosition), position, __ATOMIC_RELEASE );
+  __atomic_thread_fence( __ATOMIC_SEQ_CST );
+  if( (intptr_t) ( __atomic_load_n( &(queue->discardPosition), __ATOMIC_RELAXED ) - position ) <= 0 ) return true;
+  __atomic_store_n( &(queue->pinnedPosition), NO_POSITION, __ATOMIC_RELEASE );
+  
+  return false;
+}
+
+// Finds up to given number of free slots at the write position of a single producer/consumer queue. A full queue 
+// gets its oldest item dropped by moving the discard position past it, so that the read position is only written by the consumer. 
+// Slots of dropped items are reused before being released by the consumer, except the one it's reading in place
+static size_t ClaimWriteSlotsSPSC( TSQueue queue, size_t maxCount, size_t* outPosition, bool canOverwrite )
+{
+  size_t position = queue->last;
+  size_t overwriteSpinsCount = 0;
+  while( true )
+  {
+    size_t oldestPosition = GetOldestPosition( queue->cachedFirst, queue->discardPosition );
+    if( maxCount > queue->capacity - ( position - oldestPosition ) )
+    {
+      queue->cachedFirst = __atomic_load_n( &(queue->first), __ATOMIC_ACQUIRE );
+      oldestPosition = GetOldestPosition( queue->cachedFirst, queue->discardPosition );
+    }
+    size_t count = queue->capacity - ( position - oldestPosition );
+    if( count == 0 && canOverwrite )
+    {
+      __atomic_store_n( &(queue->discardPosition), oldestPosition + 1, __ATOMIC_RELAXED );
+      __atomic_thread_fence( __ATOMIC_SEQ_CST );
+      count = 1;
+    }
+    if( count > maxCount ) count = maxCount;
+    
+    size_t reusedPosition = position - queue->capacity;
+    if( (intptr_t) ( reusedPosition + count - queue->cachedFirst ) > 0 )
+    {
+      // Acquiring the pin orders the write after the consumer's reads of a slot it unpinned
+      size_t pinnedPosition = __atomic_load_n( &(queue->pinnedPosition), __ATOMIC_ACQUIRE );
+      if( pinnedPosition != NO_POSITION && pinnedPosition - reusedPosition < count ) count = pinnedPosition - reusedPosition;
+    }
+    
+    if( count > 0 || !canOverwrite || overwriteSpinsCount++ >= OVERWRITE_SPIN_COUNT )
+    {
+      *outPosition = position;
+      return count;
+    }
+    Atomic_Pause();
+  }
+}
+
+// Takes up to given number of consecutive oldest item slots for reading, returning how many were available
+static size_t ClaimReadSlots( TSQueue queue, size_t maxCount, size_t* outPosition )
 {
-  static void* dataOut = NULL;
+  if( queue->type == TSQUEUE_SPSC ) return ClaimReadSlotsSPSC( queue, maxCount, outPosition );
   
-  if( buffer == NULL ) return false;
+  // Positions are claimed atomically, as producers can also discard the oldest item
+  size_t position = __atomic_load_n( &(queue->first), __ATOMIC_RELAXED );
+  while( true )
+  {
+    size_t sequence = __atomic_load_n( &(GetSlot( queue, position )->sequence), __ATOMIC_ACQUIRE );
+    intptr_t difference = (intptr_t) ( sequence - ( position + 1 ) );
+    if( difference == 0 )
+    {
+      // Ready slots can only be taken by moving the read position past them, so checking all before claiming is safe
+      size_t count = 1;
+      while( count < maxCount && __atomic_load_n( &(GetSlot( queue, position + count )->sequence), __ATOMIC_ACQUIRE ) == position + count + 1 )
+        count++;
+      if( __atomic_compare_exchange_n( &(queue->first), &position, position + count, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED ) )
+      {
+        *outPosition = position;
+        return count;
+      }
+    }
+    else if( difference < 0 ) return 0;
+    // Slot was already read (and maybe written again) for a later lap: position is outdated
+    else position = __atomic_load_n( &(queue->first), __ATOMIC_RELAXED );
+  }
+}
+
+// Frees given read slot for writing the next lap of positions
+static inline void ReleaseReadSlot( TSQueue queue, QueueSlot* slot, size_t position )
+{
+  __atomic_store_n( &(slot->sequence), position + queue->capacity, __ATOMIC_RELEASE );
+}
 
-  if( mode == TSQUEUE_NOWAIT && TSQ_GetItemsCount( queue ) == 0 )
-    return false;
+// Takes up to given number of consecutive free slots for writing, returning how many were available. 
+// Full queues might get its oldest item discarded for that
+static size_t ClaimWriteSlots( TSQueue queue, size_t maxCount, size_t* outPosition, bool canOverwrite )
+{
+  if( queue->type == TSQUEUE_SPSC ) return ClaimWriteSlotsSPSC( queue, maxCount, outPosition, canOverwrite );
   
-  Sem_Decrement( queue->countLock );
+  size_t position = __atomic_load_n( &(queue->last), __ATOMIC_RELAXED );
+  size_t overwriteSpinsCount = 0;
+  while( true )
+  {
+    QueueSlot* slot = GetSlot( queue, position );
+    size_t sequence = __atomic_load_n( &(slot->sequence), __ATOMIC_ACQUIRE );
+    intptr_t difference = (intptr_t) ( sequence - position );
+    if( difference == 0 )
+    {
+      size_t count = 1;
+      while( count < maxCount && __atomic_load_n( &(GetSlot( queue, position + count )->sequence), __ATOMIC_ACQUIRE ) == position + count )
+        count++;
+      if( !__atomic_compare_exchange_n( &(queue->last), &position, position + count, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED ) )
+        continue;
+      *outPosition = position;
+      return count;
+    }
+    else if( difference > 0 ) 
+    {
+      position = __atomic_load_n( &(queue->last), __ATOMIC_RELAXED );
+      continue;
+    }
+    
+    if( !canOverwrite || overwriteSpinsCount++ >= OVERWRITE_SPIN_COUNT ) return 0;
+    
+    // Only the item at the exact slot to be written is discarded. If a reader took it first, wait for its release
+    size_t oldestPosition = position - queue->capacity;
+    if( sequence == oldestPosition + 1 &&
+        __atomic_compare_exchange_n( &(queue->first), &oldestPosition, oldestPosition + 1, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED ) )
+      ReleaseReadSlot( queue, slot, position - queue->capacity );
+    else
+      Atomic_Pause();
+  }
+}
+
+static size_t ClaimWriteSlotsNoOverwrite( TSQueue queue, size_t maxCount, size_t* outPosition )
+{
+  return ClaimWriteSlots( queue, maxCount, outPosition, false );
+}
+
+// Blocks caller on given event until notified or deadline is reached, unless given claim succeeds after registering as waiter
+static bool WaitSlots( TSQueue queue, TEventCount event, size_t (*ClaimSlots)( TSQueue, size_t, size_t* ), 
+                       size_t maxCount, size_t* outCount, size_t* outPosition, uint64_t deadline )
+{
+  uint32_t key = TEventCount_PrepareWait( event );
+  *outCount = ClaimSlots( queue, maxCount, outPosition );
+  if( *outCount > 0 ) 
+  {
+    TEventCount_CancelWait( event );
+    return true;
+  }
+  if( TEventCount_CommitWait( event, key, Atomic_GetTimeout( deadline ) ) ) return true;
+  // Last chance for slots made available right before timeout
+  *outCount = ClaimSlots( queue, maxCount, outPosition );
   
+  return ( *outCount > 0 );
+}
+
+static size_t EnqueueLockFree( TSQueue queue, uint8_t* items, size_t count, enum TSQueueAccessMode mode, uint64_t deadline )
+{
+  size_t position = 0;
+  size_t insertedCount = 0;
+  while( insertedCount < count )
+  {
+    size_t claimedCount = ClaimWriteSlots( queue, count - insertedCount, &position, ( mode == TSQUEUE_NOWAIT ) );
+    // Waiting insertion stops when queue gets full, after the first claimed slots
+    while( claimedCount == 0 )
+    {
+      if( mode == TSQUEUE_NOWAIT || insertedCount > 0 ) return insertedCount;
+      if( !WaitSlots( queue, queue->spaceEvent, ClaimWriteSlotsNoOverwrite, count, &claimedCount, &position, deadline ) ) return 0;
+    }
+    
+    if( queue->type == TSQUEUE_SPSC )
+    {
+      for( size_t i = 0; i < claimedCount; i++ )
+        CopyToSlot( GetSlot( queue, position + i ), items + ( insertedCount + i ) * queue->itemSize, queue->itemSize );
+      __atomic_store_n( &(queue->last), position + claimedCount, __ATOMIC_RELEASE );
+    }
+    else
+    {
+      for( size_t i = 0; i < claimedCount; i++ )
+      {
+        QueueSlot* slot = GetSlot( queue, position + i );
+        memcpy( slot->data, items + ( insertedCount + i ) * queue->itemSize, queue->itemSize );
+        __atomic_store_n( &(slot->sequence), position + i + 1, __ATOMIC_RELEASE );
+      }
+    }
+    insertedCount += claimedCount;
+    TEventCount_Notify( queue->itemsEvent );
+    NotifyWatchers( queue );
+    
+    if( mode == TSQUEUE_WAIT ) break;
+  }
+  
+  return insertedCount;
+}
+
+static size_t DequeueLockFree( TSQueue queue, uint8_t* buffer, size_t maxCount, enum TSQueueAccessMode mode, uint64_t deadline )
+{
+  size_t position = 0;
+  size_t count = 0;
+  while( true )
+  {
+    count = ClaimReadSlots( queue, maxCount, &position );
+    while( count == 0 )
+    {
+      if( mode == TSQUEUE_NOWAIT || !WaitSlots( queue, queue->itemsEvent, ClaimReadSlots, maxCount, &count, &position, deadline ) ) return 0;
+    }
+    
+    if( queue->type != TSQUEUE_SPSC )
+    {
+      for( size_t i = 0; i < count; i++ )
+      {
+        QueueSlot* slot = GetSlot( queue, position + i );
+        memcpy( buffer + i * queue->itemSize, slot->data, queue->itemSize );
+        ReleaseReadSlot( queue, slot, position + i );
+      }
+      break;
+    }
+    
+    for( size_t i = 0; i < count; i++ )
+      CopyFromSlot( buffer + i * queue->itemSize, GetSlot( queue, position + i ), queue->itemSize );
+    // Copy is retried from the new oldest item if these got dropped
+    if( ReleaseReadSlotsSPSC( queue, position, count ) ) break;
+  }
+  TEventCount_Notify( queue->spaceEvent );
+  
+  return count;
+}
+
+// Finds the slot holding given item data, handed out to users for in place access
+static inline QueueSlot* GetItemSlot( void* item )
+{
+  return (QueueSlot*) ( (uint8_t*) item - offsetof( QueueSlot, data ) );
+}
+
+// Locked queues keep their access lock held until write is committed
+static void* ReserveWriteLocked( TSQueue queue, enum TSQueueAccessMode mode )
+{
   TLock_Acquire( queue->accessLock );
-  dataOut = queue->cache[ queue->first % queue->maxLength ];
-  buffer = memcpy( buffer, dataOut, queue->itemSize );
-  queue->first++;
-  TLock_Release( queue->accessLock );
+  while( queue->last - queue->first >= queue->maxLength )
+  {
+    if( mode == TSQUEUE_NOWAIT || !WaitSignal( queue, &(queue->writersWaiting), queue->writeSignal, ATOMIC_TIME_INFINITE ) )
+    {
+      if( queue->last - queue->first < queue->maxLength ) break;
+      TLock_Release( queue->accessLock );
+      return NULL;
+    }
+  }
+  
+  QueueSlot* slot = GetWriteSlotLocked( queue );
+  if( slot == NULL )
+  {
+    TLock_Release( queue->accessLock );
+    return NULL;
+  }
+  
+  return slot->data;
+}
+
+static void* ReserveWriteLockFree( TSQueue queue, enum TSQueueAccessMode mode )
+{
+  size_t position = 0;
+  size_t count = ClaimWriteSlots( queue, 1, &position, false );
+  while( count == 0 )
+  {
+    if( mode == TSQUEUE_NOWAIT || !WaitSlots( queue, queue->spaceEvent, ClaimWriteSlotsNoOverwrite, 1, &count, &position, ATOMIC_TIME_INFINITE ) ) return NULL;
+  }
+  
+  return GetSlot( queue, position )->data;
+}
+
+// Locked queues keep their access lock held until read is released
+static void* PeekReadLocked( TSQueue queue, enum TSQueueAccessMode mode )
+{
+  TLock_Acquire( queue->accessLock );
+  while( queue->last == queue->first )
+  {
+    if( mode == TSQUEUE_NOWAIT || !WaitSignal( queue, &(queue->readersWaiting), queue->readSignal, ATOMIC_TIME_INFINITE ) )
+    {
+      if( queue->last > queue->first ) break;
+      TLock_Release( queue->accessLock );
+      return NULL;
+    }
+  }
+  
+  return GetReadSlotLocked( queue )->data;
+}
+
+static void* PeekReadLockFree( TSQueue queue, enum TSQueueAccessMode mode )
+{
+  size_t position = 0;
+  do
+  {
+    size_t count = ClaimReadSlots( queue, 1, &position );
+    while( count == 0 )
+    {
+      if( mode == TSQUEUE_NOWAIT || !WaitSlots( queue, queue->itemsEvent, ClaimReadSlots, 1, &count, &position, ATOMIC_TIME_INFINITE ) ) return NULL;
+    }
+  }
+  while( queue->type == TSQUEUE_SPSC && !PinReadSlotSPSC( queue, position ) );
+  
+  return GetSlot( queue, position )->data;
+}
+
+static size_t Enqueue( TSQueue queue, void* items, size_t count, enum TSQueueAccessMode mode, uint64_t deadline )
+{
+  if( queue == NULL || items == NULL || count == 0 ) return 0;
+  
+  if( !IsLockFree( queue ) ) return EnqueueLocked( queue, (uint8_t*) items, count, mode, deadline );
+  return EnqueueLockFree( queue, (uint8_t*) items, count, mode, deadline );
+}
+
+static size_t Dequeue( TSQueue queue, void* buffer, size_t maxCount, enum TSQueueAccessMode mode, uint64_t deadline )
+{
+  if( queue == NULL || buffer == NULL || maxCount == 0 ) return 0;
+  
+  size_t count = 0;
+  if( !IsLockFree( queue ) ) count = DequeueLocked( queue, (uint8_t*) buffer, maxCount, mode, deadline );
+  else count = DequeueLockFree( queue, (uint8_t*) buffer, maxCount, mode, deadline );
+  if( count == 0 ) ResetEvent( queue );
+  
+  return count;
+}
+
+bool TSQ_Enqueue( TSQueue queue, void* buffer, enum TSQueueAccessMode mode )
+{
+  return ( Enqueue( queue, buffer, 1, mode, ATOMIC_TIME_INFINITE ) == 1 );
+}
+
+bool TSQ_EnqueueTimed( TSQueue queue, void* buffer, unsigned int milliseconds )
+{
+  return ( Enqueue( queue, buffer, 1, TSQUEUE_WAIT, Atomic_GetDeadline( milliseconds ) ) == 1 );
+}
+
+size_t TSQ_EnqueueBatch( TSQueue queue, void* items, size_t count, enum TSQueueAccessMode mode )
+{
+  return Enqueue( queue, items, count, mode, ATOMIC_TIME_INFINITE );
+}
+
+bool TSQ_Dequeue( TSQueue queue, void* buffer, enum TSQueueAccessMode mode )
+{
+  return ( Dequeue( queue, buffer, 1, mode, ATOMIC_TIME_INFINITE ) == 1 );
+}
+
+bool TSQ_DequeueTimed( TSQueue queue, void* buffer, unsigned int milliseconds )
+{
+  return ( Dequeue( queue, buffer, 1, TSQUEUE_WAIT, Atomic_GetDeadline( milliseconds ) ) == 1 );
+}
+
+size_t TSQ_DequeueBatch( TSQueue queue, void* buffer, size_t maxCount, enum TSQueueAccessMode mode )
+{
+  return Dequeue( queue, buffer, maxCount, mode, ATOMIC_TIME_INFINITE );
+}
+
+void* TSQ_ReserveWrite( TSQueue queue, enum TSQueueAccessMode mode )
+{
+  if( queue == NULL ) return NULL;
+  
+  if( !IsLockFree( queue ) ) return ReserveWriteLocked( queue, mode );
+  return ReserveWriteLockFree( queue, mode );
+}
+
+void TSQ_CommitWrite( TSQueue queue, void* item )
+{
+  if( queue == NULL || item == NULL ) return;
+  
+  if( !IsLockFree( queue ) )
+  {
+    __atomic_store_n( &(queue->last), queue->last + 1, __ATOMIC_RELAXED );
+    PostSignal( &(queue->readersWaiting), queue->readSignal, 1 );
+    TLock_Release( queue->accessLock );
+    __atomic_thread_fence( __ATOMIC_SEQ_CST );
+    NotifyWatchers( queue );
+    return;
+  }
+  
+  if( queue->type == TSQUEUE_SPSC ) __atomic_store_n( &(queue->last), queue->last + 1, __ATOMIC_RELEASE );
+  else
+  {
+    // Claimed write slot keeps the sequence number of its position until published
+    QueueSlot* slot = GetItemSlot( item );
+    size_t position = __atomic_load_n( &(slot->sequence), __ATOMIC_RELAXED );
+    __atomic_store_n( &(slot->sequence), position + 1, __ATOMIC_RELEASE );
+  }
+  TEventCount_Notify( queue->itemsEvent );
+  NotifyWatchers( queue );
+}
+
+void* TSQ_PeekRead( TSQueue queue, enum TSQueueAccessMode mode )
+{
+  if( queue == NULL ) return NULL;
+  
+  void* item = !IsLockFree( queue ) ? PeekReadLocked( queue, mode ) : PeekReadLockFree( queue, mode );
+  if( item == NULL ) ResetEvent( queue );
+  
+  return item;
+}
+
+void TSQ_ReleaseRead( TSQueue queue, void* item )
+{
+  if( queue == NULL || item == NULL ) return;
+  
+  if( !IsLockFree( queue ) )
+  {
+    __atomic_store_n( &(queue->first), queue->first + 1, __ATOMIC_RELAXED );
+    PostSignal( &(queue->writersWaiting), queue->writeSignal, 1 );
+    TLock_Release( queue->accessLock );
+    return;
+  }
+  
+  if( queue->type == TSQUEUE_SPSC )
+  {
+    __atomic_store_n( &(queue->first), queue->pinnedPosition + 1, __ATOMIC_RELEASE );
+    __atomic_store_n( &(queue->pinnedPosition), NO_POSITION, __ATOMIC_RELEASE );
+  }
+  else
+  {
+    // Claimed read slot keeps the sequence number of its position plus one until released
+    QueueSlot* slot = GetItemSlot( item );
+    size_t position = __atomic_load_n( &(slot->sequence), __ATOMIC_RELAXED ) - 1;
+    ReleaseReadSlot( queue, slot, position );
+  }
+  TEventCount_Notify( queue->spaceEvent );
+}
+
+
+int TSQ_GetEventDescriptor( TSQueue queue )
+{
+  if( queue == NULL ) return -1;
+  
+  int descriptor = __atomic_load_n( &(queue->eventDescriptor), __ATOMIC_ACQUIRE );
+#ifdef __linux__
+  if( descriptor >= 0 ) return descriptor;
+  
+  descriptor = eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC );
+  if( descriptor < 0 ) return -1;
+  int noDescriptor = -1;
+  if( !__atomic_compare_exchange_n( &(queue->eventDescriptor), &noDescriptor, descriptor, false, __ATOMIC_SEQ_CST, __ATOMIC_ACQUIRE ) )
+  {
+    close( descriptor );
+    return noDescriptor;
+  }
+  // Items inserted before descriptor creation didn't signal it
+  if( TSQ_GetItemsCount( queue ) > 0 ) SignalEvent( queue, descriptor );
+#endif
+  return descriptor;
+}
+
+TSQueueSet TSQ_CreateSet()
+{
+  TSQueueSet set = (TSQueueSet) malloc( sizeof(TSQueueSetData) );
+  
+  set->queuesList = NULL;
+  set->queuesCount = 0;
+  set->accessLock = TLock_Create();
+  set->event = TEventCount_Create();
+  
+  return set;
+}
+
+// Stops given queue from notifying its set event, waiting for insertions that might still be using it. 
+// Either a notifier gets counted before the event is unlinked, or it finds the event unlinked
+static void UnlinkSetEvent( TSQueue queue )
+{
+  __atomic_store_n( &(queue->setEvent), NULL, __ATOMIC_SEQ_CST );
+  while( __atomic_load_n( &(queue->setNotifiersCount), __ATOMIC_SEQ_CST ) > 0 ) Atomic_Yield();
+}
+
+void TSQ_DiscardSet( TSQueueSet set )
+{
+  if( set == NULL ) return;
+  
+  for( size_t queueIndex = 0; queueIndex < set->queuesCount; queueIndex++ )
+    UnlinkSetEvent( set->queuesList[ queueIndex ] );
+  free( set->queuesList );
+  
+  TLock_Discard( set->accessLock );
+  TEventCount_Discard( set->event );
+  
+  free( set );
+}
+
+bool TSQ_AddToSet( TSQueueSet set, TSQueue queue )
+{
+  if( set == NULL || queue == NULL ) return false;
+  
+  TEventCount noEvent = NULL;
+  if( !__atomic_compare_exchange_n( &(queue->setEvent), &noEvent, set->event, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED ) ) return false;
+  
+  TLock_Acquire( set->accessLock );
+  set->queuesList = (TSQueue*) realloc( set->queuesList, ( set->queuesCount + 1 ) * sizeof(TSQueue) );
+  set->queuesList[ set->queuesCount++ ] = queue;
+  TLock_Release( set->accessLock );
   
   return true;
 }
+
+void TSQ_RemoveFromSet( TSQueueSet set, TSQueue queue )
+{
+  if( set == NULL || queue == NULL ) return;
+  
+  TLock_Acquire( set->accessLock );
+  for( size_t queueIndex = 0; queueIndex < set->queuesCount; queueIndex++ )
+  {
+    if( set->queuesList[ queueIndex ] == queue )
+    {
+      set->queuesList[ queueIndex ] = set->queuesList[ --set->queuesCount ];
+      UnlinkSetEvent( queue );
+      break;
+    }
+  }
+  TLock_Release( set->accessLock );
+}
+
+// Lists set queues holding items, up to given count
+static size_t FindReadableQueues( TSQueueSet set, TSQueue* readyQueuesList, size_t maxCount )
+{
+  size_t readyCount = 0;
+  TLock_Acquire( set->accessLock );
+  for( size_t queueIndex = 0; queueIndex < set->queuesCount && readyCount < maxCount; queueIndex++ )
+  {
+    if( TSQ_GetItemsCount( set->queuesList[ queueIndex ] ) > 0 ) 
+      readyQueuesList[ readyCount++ ] = set->queuesList[ queueIndex ];
+  }
+  TLock_Release( set->accessLock );
+  
+  return readyCount;
+}
+
+size_t TSQ_WaitSet( TSQueueSet set, TSQueue* readyQueuesList, size_t maxCount, unsigned int milliseconds )
+{
+  if( set == NULL || readyQueuesList == NULL || maxCount == 0 ) return 0;
+  
+  uint64_t deadline = Atomic_GetDeadline( milliseconds );
+  while( true )
+  {
+    // Registering as waiter before checking queues guarantees that later insertions awake the caller
+    uint32_t key = TEventCount_PrepareWait( set->event );
+    size_t readyCount = FindReadableQueues( set, readyQueuesList, maxCount );
+    if( readyCount > 0 )
+    {
+      TEventCount_CancelWait( set->event );
+      return readyCount;
+    }
+    if( milliseconds == 0 || !TEventCount_CommitWait( set->event, key, Atomic_GetTimeout( deadline ) ) ) 
+      return FindReadableQueues( set, readyQueuesList, maxCount );
+  }
+}
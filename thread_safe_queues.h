@@ -37,6 +37,11 @@ typedef struct _TSQueueData TSQueueData;
 /// Opaque reference to thread safe queue data structure
 typedef TSQueueData* TSQueue;
 
+/// Structure holding a set of thread safe queues for waiting on all of them at once
+typedef struct _TSQueueSetData TSQueueSetData;
+/// Opaque reference to thread safe queue set data structure
+typedef TSQueueSetData* TSQueueSet;
+
 /// Option to control behaviour of queue access on empty or full cases
 enum TSQueueAccessMode 
 { 
@@ -44,6 +49,15 @@ enum TSQueueAccessMode
   TSQUEUE_NOWAIT              ///< Automatically return when reading empty queue or overwrite when writing to full queue
 };
 
+/// Queue synchronization strategy, defined on creation
+enum TSQueueType
+{
+  TSQUEUE_LOCKED,             ///< Lock and signal based queue, for any number of producer and consumer threads (default)
+  TSQUEUE_SPSC,               ///< Lock-free queue for a single producer thread and a single consumer thread
+  TSQUEUE_MPMC,               ///< Lock-free queue for any number of producer and consumer threads
+  TSQUEUE_UNBOUNDED           ///< Lock based queue that never gets full, growing (and shrinking back) by linked segments of maximum length items (insertion fails if they can't be allocated)
+};
+
                                                                     
 /// @brief Creates new thread safe queue data structure                                               
 /// @param[in] maxLength maximum queue lenght (number of items)                                   
@@ -51,6 +65,14 @@ enum TSQueueAccessMode
 /// @return reference to newly created queue data structure
 TSQueue TSQ_Create( size_t maxLength, size_t itemSize );
 
+/// @brief Creates new thread safe queue data structure with given synchronization strategy
+/// @param[in] maxLength maximum queue lenght (number of items)
+/// @param[in] itemSize size (in bytes) of created queue items
+/// @param[in] type queue synchronization strategy (lock-free queues have their maximum length rounded up to a power of two, 
+/// and could fail to overwrite an item being read at the same time)
+/// @return reference to newly created queue data structure
+TSQueue TSQ_CreateType( size_t maxLength, size_t itemSize, enum TSQueueType type );
+
 /// @brief Deallocates given thread safe queue data structure                            
 /// @param[in] queue reference to queue
 void TSQ_Discard( TSQueue queue );
@@ -74,5 +96,91 @@ bool TSQ_Enqueue( TSQueue queue, void* buffer, enum TSQueueAccessMode mode );
 /// @return true on successful copy/removal, false otherwise 
 bool TSQ_Dequeue( TSQueue queue, void* buffer, enum TSQueueAccessMode mode );
 
+/// @brief Copies multiple contiguous items to the end of given thread safe queue, under a single synchronization
+/// @param[in] queue reference to queue
+/// @param[in] items opaque pointer to array of inserted variables
+/// @param[in] count number of items in the array
+/// @param[in] mode insertion behaviour (TSQUEUE_WAIT to wait for space for the first item, inserting only what fits, or TSQUEUE_NOWAIT to overwrite older items)
+/// @return number of inserted items
+size_t TSQ_EnqueueBatch( TSQueue queue, void* items, size_t count, enum TSQueueAccessMode mode );
+
+/// @brief Copies first items of the thread safe queue to given buffer and removes them from queue, under a single synchronization
+/// @param[in] queue reference to queue
+/// @param[out] buffer opaque pointer to preallocated array of variables
+/// @param[in] maxCount maximum number of removed items (array length)
+/// @param[in] mode removal behaviour (TSQUEUE_WAIT to wait for the first item, or TSQUEUE_NOWAIT to return if queue is empty)
+/// @return number of removed items
+size_t TSQ_DequeueBatch( TSQueue queue, void* buffer, size_t maxCount, enum TSQueueAccessMode mode );
+
+/// @brief Copies given item to the end of given thread safe queue, waiting a limited time for space if it is full
+/// @param[in] queue reference to queue
+/// @param[in] buffer opaque pointer to inserted variable
+/// @param[in] milliseconds maximum time (in milliseconds, measured with monotonic clock) for waiting (INFINITE to wait indefinitely)
+/// @return true on successful copy/insertion, false on timeout or errors (queue is never overwritten)
+bool TSQ_EnqueueTimed( TSQueue queue, void* buffer, unsigned int milliseconds );
+
+/// @brief Copies first item of the thread safe queue to given buffer and removes it from queue, waiting a limited time for data if it is empty
+/// @param[in] queue reference to queue
+/// @param[out] buffer opaque pointer to preallocated buffer for variable
+/// @param[in] milliseconds maximum time (in milliseconds, measured with monotonic clock) for waiting (INFINITE to wait indefinitely)
+/// @return true on successful copy/removal, false on timeout or errors
+bool TSQ_DequeueTimed( TSQueue queue, void* buffer, unsigned int milliseconds );
+
+/// @brief Gets direct reference to the next free item slot at the end of given thread safe queue, for writing it in place (should be committed afterwards)
+/// @param[in] queue reference to queue
+/// @param[in] mode reservation behaviour (TSQUEUE_WAIT to wait for space, or TSQUEUE_NOWAIT to return if queue is full, never overwriting)
+/// @return pointer to item slot data (NULL if queue is full on TSQUEUE_NOWAIT mode, or on errors). Locked queues can't be accessed by other threads until commit
+void* TSQ_ReserveWrite( TSQueue queue, enum TSQueueAccessMode mode );
+
+/// @brief Makes item written in place available for reading
+/// @param[in] queue reference to queue
+/// @param[in] item pointer returned by the preceding TSQ_ReserveWrite() call
+void TSQ_CommitWrite( TSQueue queue, void* item );
+
+/// @brief Gets direct reference to first item of the thread safe queue, for reading it in place (should be released afterwards)
+/// @param[in] queue reference to queue
+/// @param[in] mode reading behaviour (TSQUEUE_WAIT to wait for data, or TSQUEUE_NOWAIT to return if queue is empty)
+/// @return pointer to item slot data (NULL if queue is empty on TSQUEUE_NOWAIT mode). Locked queues can't be accessed by other threads until release
+void* TSQ_PeekRead( TSQueue queue, enum TSQueueAccessMode mode );
+
+/// @brief Removes item read in place from queue, freeing its slot for writing
+/// @param[in] queue reference to queue
+/// @param[in] item pointer returned by the preceding TSQ_PeekRead() call
+void TSQ_ReleaseRead( TSQueue queue, void* item );
+
+/// @brief Gets pollable descriptor (Linux eventfd, created on first call) that is readable while given queue has items, for use on poll/epoll event loops. 
+/// Bursts of insertions signal it only once, and readiness is reset when reading finds queue empty (descriptor shouldn't be read or closed by the caller)
+/// @param[in] queue reference to queue
+/// @return file descriptor (-1 on errors or on systems without eventfd)
+int TSQ_GetEventDescriptor( TSQueue queue );
+
+/// @brief Creates new (empty) set of thread safe queues, for waiting on multiple queues at once
+/// @return reference to newly created queue set
+TSQueueSet TSQ_CreateSet();
+
+/// @brief Deallocates given queue set data structure, removing all its queues from it (no thread should be waiting on it). 
+/// Insertions into its queues can go on, as the set is only freed after the ones notifying it return
+/// @param[in] set reference to queue set
+void TSQ_DiscardSet( TSQueueSet set );
+
+/// @brief Adds given queue to a set (a queue can belong to a single set at a time, and should be removed from it before being discarded)
+/// @param[in] set reference to queue set
+/// @param[in] queue reference to added queue
+/// @return true on successful insertion, false if queue already belongs to a set
+bool TSQ_AddToSet( TSQueueSet set, TSQueue queue );
+
+/// @brief Removes given queue from a set, waiting for insertions that might still be notifying the set through it
+/// @param[in] set reference to queue set
+/// @param[in] queue reference to removed queue
+void TSQ_RemoveFromSet( TSQueueSet set, TSQueue queue );
+
+/// @brief Blocks calling thread until any queue of the set has items to be read, or timeout is reached
+/// @param[in] set reference to queue set
+/// @param[out] readyQueuesList preallocated array to receive references to readable queues
+/// @param[in] maxCount maximum number of readable queues to be listed (array length)
+/// @param[in] milliseconds maximum time (in milliseconds, measured with monotonic clock) for waiting (INFINITE to wait indefinitely)
+/// @return number of readable queues listed (0 on timeout). Items could still be taken by other readers before listed queues are accessed
+size_t TSQ_WaitSet( TSQueueSet set, TSQueue* readyQueuesList, size_t maxCount, unsigned int milliseconds );
+
 
 #endif // THREAD_SAFE_QUEUES_H
@@ -19,27 +19,121 @@
 //                                                                                  //
 //////////////////////////////////////////////////////////////////////////////////////
 
+#ifndef _GNU_SOURCE
+  #define _GNU_SOURCE
+#endif
+
 #include "threads.h"
 
+#include <string.h>
+#include <stdbool.h>
+
+void Thread_InitAttributes( ThreadAttributes* attributes )
+{
+  if( attributes == NULL ) return;
+  
+  memset( attributes, 0, sizeof(ThreadAttributes) );
+  attributes->schedulingPolicy = THREAD_SCHED_DEFAULT;
+  attributes->name = NULL;
+  attributes->numaNode = THREAD_NUMA_ANY;
+}
+
+void Thread_AddAffinityCPU( ThreadAttributes* attributes, size_t cpuIndex )
+{
+  if( attributes == NULL || cpuIndex >= THREAD_MAX_CPUS ) return;
+  
+  attributes->affinityMask[ cpuIndex / 64 ] |= ( (uint64_t) 1 << ( cpuIndex % 64 ) );
+}
+
+// Checks if any logical processor is set on given affinity mask
+static bool HasAffinity( const uint64_t* affinityMask )
+{
+  for( size_t i = 0; i < THREAD_MAX_CPUS / 64; i++ )
+  {
+    if( affinityMask[ i ] != 0 ) return true;
+  }
+  
+  return false;
+}
+
 #ifdef WIN32
 
 #include <Windows.h>
 
 #include <stdlib.h>  
 #include <stdio.h> 
+#include <errno.h>
 
 // Setup new thread to run the given method asynchronously
 Thread Thread_Start( AsyncFunction function, void* args, enum ThreadResourceMode mode )
 {
-  static HANDLE handle;
-  static unsigned int threadID;
+  return Thread_StartEx( function, args, mode, NULL );
+}
+
+// Map POSIX-like real-time priority (1-99) onto the priority levels above normal of Windows
+static int GetWindowsPriority( int priority )
+{
+  if( priority <= 33 ) return THREAD_PRIORITY_ABOVE_NORMAL;
+  else if( priority <= 66 ) return THREAD_PRIORITY_HIGHEST;
+  
+  return THREAD_PRIORITY_TIME_CRITICAL;
+}
+
+// Setup new thread with given attributes to run the given method asynchronously
+Thread Thread_StartEx( AsyncFunction function, void* args, enum ThreadResourceMode mode, const ThreadAttributes* attributes )
+{
+  HANDLE handle;
+  DWORD threadID;
+  SIZE_T stackSize = ( attributes != NULL ) ? attributes->stackSize : 0;
   
-  if( (handle = CreateThread( NULL, 0, (LPTHREAD_START_ROUTINE) function, args, 0, &threadID )) == THREAD_INVALID_HANDLE )
+  // Affinity can only be set inside the processor group of the process (a single DWORD_PTR mask)
+  if( attributes != NULL && HasAffinity( attributes->affinityMask ) )
   {
-    perror( "Thread_Start: CreateThread: " );
+    bool isGroupMask = ( ( attributes->affinityMask[ 0 ] & ~( (uint64_t) (DWORD_PTR) -1 ) ) == 0 );
+    for( size_t i = 1; i < THREAD_MAX_CPUS / 64; i++ )
+    {
+      if( attributes->affinityMask[ i ] != 0 ) isGroupMask = false;
+    }
+    if( !isGroupMask )
+    {
+      errno = EINVAL;
+      perror( "Thread_StartEx: processor affinity (beyond process group): " );
+      return THREAD_INVALID_HANDLE;
+    }
+  }
+  
+  // Attributes are applied before the thread is allowed to run (names and NUMA preferences are not supported)
+  if( (handle = CreateThread( NULL, stackSize, (LPTHREAD_START_ROUTINE) function, args, 
+                              CREATE_SUSPENDED | STACK_SIZE_PARAM_IS_A_RESERVATION, &threadID )) == THREAD_INVALID_HANDLE )
+  {
+    perror( "Thread_StartEx: CreateThread: " );
     return THREAD_INVALID_HANDLE;
   }
   
+  if( attributes != NULL )
+  {
+    bool isApplied = true;
+    if( HasAffinity( attributes->affinityMask ) && SetThreadAffinityMask( handle, (DWORD_PTR) attributes->affinityMask[ 0 ] ) == 0 )
+    {
+      perror( "Thread_StartEx: SetThreadAffinityMask: " );
+      isApplied = false;
+    }
+    if( isApplied && attributes->schedulingPolicy != THREAD_SCHED_DEFAULT && !SetThreadPriority( handle, GetWindowsPriority( attributes->priority ) ) )
+    {
+      perror( "Thread_StartEx: SetThreadPriority: " );
+      isApplied = false;
+    }
+    // Like a failed pthread_create, the suspended thread is discarded before running any of its code
+    if( !isApplied )
+    {
+      TerminateThread( handle, 0 );
+      CloseHandle( handle );
+      return THREAD_INVALID_HANDLE;
+    }
+  }
+  
+  ResumeThread( handle );
+  
   if( mode == THREAD_DETACHED ) CloseHandle( handle );
 
   return (Thread) handle;
@@ -48,8 +142,8 @@ Thread Thread_Start( AsyncFunction function, void* args, enum ThreadResourceMode
 // Wait for the thread of the given manipulator to exit and return its exiting value
 uint32_t Thread_WaitExit( Thread handle, unsigned int milliseconds )
 {
-  static DWORD exitCode = 0;
-  static DWORD exitStatus = WAIT_OBJECT_0;
+  DWORD exitCode = 0;
+  DWORD exitStatus = WAIT_OBJECT_0;
 
   if( (HANDLE) handle != THREAD_INVALID_HANDLE )
   {
@@ -72,39 +166,230 @@ unsigned long Thread_GetID()
   return GetCurrentThreadId();
 }
 
+size_t Thread_GetTopology( ThreadCPUInfo* cpus, size_t maxCount )
+{
+  SYSTEM_INFO systemInfo;
+  GetSystemInfo( &systemInfo );
+  
+  size_t cpusCount = (size_t) systemInfo.dwNumberOfProcessors;
+  for( size_t cpuIndex = 0; cpuIndex < cpusCount && cpus != NULL && cpuIndex < maxCount; cpuIndex++ )
+  {
+    ThreadCPUInfo cpuInfo = { .cpuIndex = cpuIndex, .coreIndex = cpuIndex, .packageIndex = 0, .siblingIndex = 0, .numaNode = 0 };
+    cpus[ cpuIndex ] = cpuInfo;
+  }
+  
+  return cpusCount;
+}
+
 #else // Unix
 
 #include <pthread.h>
+#include <sched.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdbool.h>
+#include <limits.h>
 #include <time.h>
 #include <errno.h>
-#include <malloc.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <dirent.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+#endif
 
+#ifndef __GLIBC__
 typedef struct _ThreadController
 {
   pthread_t handle;
   pthread_cond_t condition;
   pthread_mutex_t lock;
   void* result;
+  bool isJoined;
 } ThreadController;
+#endif
+
+// Thread function call that should set thread name and preferred NUMA memory node first
+typedef struct _ThreadLauncher
+{
+  AsyncFunction function;
+  void* args;
+  char name[ 16 ];  // Linux limit, including terminator
+  int numaNode;
+} ThreadLauncher;
+
+// Processors topology and NUMA nodes are read from sysfs, only available on Linux
+#ifdef __linux__
+
+// Parse sysfs processor list file (e.g. "0-3,8,10-11") into affinity bit mask
+static bool ReadCPUList( const char* filePath, uint64_t* affinityMask )
+{
+  FILE* listFile = fopen( filePath, "r" );
+  if( listFile == NULL ) return false;
+  
+  unsigned long first, last;
+  int separator = ',';
+  while( separator == ',' && fscanf( listFile, "%lu", &first ) == 1 )
+  {
+    last = first;
+    if( (separator = fgetc( listFile )) == '-' )
+    {
+      if( fscanf( listFile, "%lu", &last ) != 1 ) break;
+      separator = fgetc( listFile );
+    }
+    for( unsigned long cpuIndex = first; cpuIndex <= last && cpuIndex < THREAD_MAX_CPUS; cpuIndex++ )
+      affinityMask[ cpuIndex / 64 ] |= ( (uint64_t) 1 << ( cpuIndex % 64 ) );
+  }
+  
+  fclose( listFile );
+  
+  return true;
+}
+
+// Read single integer value from sysfs file
+static long ReadSysValue( const char* filePath, long defaultValue )
+{
+  FILE* valueFile = fopen( filePath, "r" );
+  if( valueFile == NULL ) return defaultValue;
+  
+  long value = defaultValue;
+  if( fscanf( valueFile, "%ld", &value ) != 1 ) value = defaultValue;
+  fclose( valueFile );
+  
+  return value;
+}
+
+#endif // __linux__
+
+// Thread entry point that applies name and NUMA memory preference before running the given method
+// (only launched on Linux, where they are set with its extensions)
+static void* LaunchThread( void* args )
+{
+  ThreadLauncher launcher = *((ThreadLauncher*) args);
+  free( args );
+  
+#ifdef __linux__
+  if( launcher.name[ 0 ] != '\0' ) pthread_setname_np( pthread_self(), launcher.name );
+  
+  unsigned long nodeMask[ THREAD_MAX_CPUS / ( 8 * sizeof(unsigned long) ) ] = { 0 };
+  if( launcher.numaNode >= 0 && launcher.numaNode < THREAD_MAX_CPUS )
+  {
+    nodeMask[ launcher.numaNode / ( 8 * sizeof(unsigned long) ) ] = 1UL << ( launcher.numaNode % ( 8 * sizeof(unsigned long) ) );
+    if( syscall( SYS_set_mempolicy, MPOL_PREFERRED, nodeMask, THREAD_MAX_CPUS + 1 ) != 0 )
+      perror( "Thread_StartEx: set_mempolicy: " );
+  }
+#endif
+  
+  return launcher.function( launcher.args );
+}
 
 // Setup new thread to run the given method asyncronously
 Thread Thread_Start( void* (*function)( void* ), void* args, enum ThreadResourceMode mode )
 {
+  return Thread_StartEx( function, args, mode, NULL );
+}
+
+// Setup new thread with given attributes to run the given method asyncronously
+Thread Thread_StartEx( void* (*function)( void* ), void* args, enum ThreadResourceMode mode, const ThreadAttributes* attributes )
+{
+#ifndef __linux__
+  // Processor affinity can only be set with Linux extensions (names and NUMA preferences are ignored elsewhere)
+  if( attributes != NULL && HasAffinity( attributes->affinityMask ) )
+  {
+    errno = ENOTSUP;
+    perror( "Thread_StartEx: processor affinity: " );
+    return THREAD_INVALID_HANDLE;
+  }
+#endif
+  
   pthread_t* handle = (pthread_t*) malloc( sizeof(pthread_t) );
+  pthread_attr_t threadAttributes;
+  ThreadLauncher* launcher = NULL;
   
-  if( pthread_create( handle, NULL, function, args ) != 0 )
+  pthread_attr_init( &threadAttributes );
+  
+  if( attributes != NULL )
   {
-    perror( "Thread_Start: pthread_create: " );
+    if( attributes->stackSize > 0 )
+      pthread_attr_setstacksize( &threadAttributes, ( attributes->stackSize > (size_t) PTHREAD_STACK_MIN ) ? attributes->stackSize : (size_t) PTHREAD_STACK_MIN );
+    
+#ifdef __linux__
+    uint64_t affinityMask[ THREAD_MAX_CPUS / 64 ];
+    memcpy( affinityMask, attributes->affinityMask, sizeof(affinityMask) );
+    if( !HasAffinity( affinityMask ) && attributes->numaNode != THREAD_NUMA_ANY )
+    {
+      char nodeListPath[ PATH_MAX ];
+      snprintf( nodeListPath, PATH_MAX, "/sys/devices/system/node/node%d/cpulist", attributes->numaNode );
+      ReadCPUList( nodeListPath, affinityMask );
+    }
+    if( HasAffinity( affinityMask ) )
+    {
+      cpu_set_t* cpuSet = CPU_ALLOC( THREAD_MAX_CPUS );
+      size_t cpuSetSize = CPU_ALLOC_SIZE( THREAD_MAX_CPUS );
+      CPU_ZERO_S( cpuSetSize, cpuSet );
+      for( size_t cpuIndex = 0; cpuIndex < THREAD_MAX_CPUS; cpuIndex++ )
+      {
+        if( affinityMask[ cpuIndex / 64 ] & ( (uint64_t) 1 << ( cpuIndex % 64 ) ) ) CPU_SET_S( cpuIndex, cpuSetSize, cpuSet );
+      }
+      pthread_attr_setaffinity_np( &threadAttributes, cpuSetSize, cpuSet );
+      CPU_FREE( cpuSet );
+    }
+#endif
+    
+    if( attributes->schedulingPolicy != THREAD_SCHED_DEFAULT )
+    {
+      struct sched_param schedulingParameters = { .sched_priority = attributes->priority };
+      pthread_attr_setinheritsched( &threadAttributes, PTHREAD_EXPLICIT_SCHED );
+      pthread_attr_setschedpolicy( &threadAttributes, ( attributes->schedulingPolicy == THREAD_SCHED_FIFO ) ? SCHED_FIFO : SCHED_RR );
+      pthread_attr_setschedparam( &threadAttributes, &schedulingParameters );
+    }
+    
+#ifdef __linux__
+    if( attributes->name != NULL || attributes->numaNode >= 0 )
+    {
+      launcher = (ThreadLauncher*) calloc( 1, sizeof(ThreadLauncher) );
+      launcher->function = function;
+      launcher->args = args;
+      if( attributes->name != NULL ) strncpy( launcher->name, attributes->name, sizeof(launcher->name) - 1 );
+      launcher->numaNode = attributes->numaNode;
+    }
+#endif
+  }
+  
+  int creationStatus = ( launcher != NULL ) ? pthread_create( handle, &threadAttributes, LaunchThread, launcher )
+                                            : pthread_create( handle, &threadAttributes, function, args );
+  pthread_attr_destroy( &threadAttributes );
+  if( creationStatus != 0 )
+  {
+    errno = creationStatus;
+    perror( "Thread_StartEx: pthread_create: " );
+    free( launcher );
+    free( handle );
     return THREAD_INVALID_HANDLE;
   }
   
-  if( mode == THREAD_DETACHED ) pthread_detach( *handle );
+  // As on Windows, handles of detached threads are released right away, being only good for error checking
+  if( mode == THREAD_DETACHED )
+  {
+    pthread_detach( *handle );
+    free( handle );
+  }
 
   return (Thread) handle;
 }
 
+#ifdef __GLIBC__
+
+// Wait (with native timed join) for the thread of the given manipulator to exit, returning false on timeout
+static bool JoinThread( pthread_t handle, const struct timespec* timeout, void** result )
+{
+  if( timeout == NULL ) return ( pthread_join( handle, result ) == 0 );
+  
+  return ( pthread_timedjoin_np( handle, result, timeout ) == 0 );
+}
+
+#else
+
 // Waiter function to be called asyncronously
 static void* Waiter( void *args )
 {
@@ -112,54 +397,75 @@ static void* Waiter( void *args )
     
   pthread_join( controller->handle, &(controller->result) );
   pthread_mutex_lock( &(controller->lock) );
+  controller->isJoined = true;
   pthread_mutex_unlock( &(controller->lock) );
   pthread_cond_signal( &(controller->condition) );
 
-  pthread_exit( NULL );
-  return 0;
+  return NULL;
 }
 
-// Wait for the thread of the given manipulator to exit and return its exiting value
-uint32_t Thread_WaitExit( Thread handle, unsigned int milliseconds )
+// Wait (with helper waiter thread) for the thread of the given manipulator to exit, returning false on timeout
+static bool JoinThread( pthread_t handle, const struct timespec* timeout, void** result )
 {
-  static struct timespec timeout;
+  if( timeout == NULL ) return ( pthread_join( handle, result ) == 0 );
+  
+  ThreadController controlArgs = { .handle = handle, .result = NULL, .isJoined = false };
   pthread_t controlHandle;
-  ThreadController controlArgs = { .handle = *((pthread_t*) handle) };
-  int controlResult;
+  int controlResult = 0;
+  
+  pthread_mutex_init( &(controlArgs.lock), 0 );
+  pthread_cond_init( &(controlArgs.condition), 0 );
+  pthread_mutex_lock( &(controlArgs.lock) );
 
-  if( handle != THREAD_INVALID_HANDLE )
+  if( pthread_create( &controlHandle, NULL, Waiter, (void*) &controlArgs ) != 0 )
   {
-    clock_gettime( CLOCK_REALTIME, &timeout );
+    perror( "Thread_WaitExit: pthread_create: error creating waiter thread:" );
+    pthread_mutex_unlock( &(controlArgs.lock) );
+    return false;
+  }
 
-    if( timeout.tv_sec + ( milliseconds / 1000 ) < INFINITE )
-    {
-      timeout.tv_sec += (time_t) ( milliseconds / 1000 );
-      timeout.tv_nsec += (long) 1000000 * ( milliseconds % 1000 );
-    }
+  while( !controlArgs.isJoined && controlResult != ETIMEDOUT )
+    controlResult = pthread_cond_timedwait( &(controlArgs.condition), &(controlArgs.lock), timeout );
   
-    pthread_mutex_init( &(controlArgs.lock), 0 );
-    pthread_cond_init( &(controlArgs.condition), 0 );
-    pthread_mutex_lock( &(controlArgs.lock) );
+  bool isJoined = controlArgs.isJoined;
+  pthread_mutex_unlock( &(controlArgs.lock) );
+  
+  if( !isJoined ) pthread_cancel( controlHandle );
+  pthread_join( controlHandle, NULL );
 
-    if( pthread_create( &controlHandle, NULL, Waiter, (void*) &controlArgs ) != 0 )
-    {
-      perror( "wait_thread_end: pthread_create: error creating waiter thread:" );
-      return 0;
-    }
+  pthread_cond_destroy( &(controlArgs.condition) );
+  pthread_mutex_destroy( &(controlArgs.lock) );
   
-    do controlResult = pthread_cond_timedwait( &(controlArgs.condition), &(controlArgs.lock), &timeout );
-    while( controlArgs.result != NULL && controlResult != ETIMEDOUT );
+  *result = controlArgs.result;
+  
+  return isJoined;
+}
+
+#endif
 
-    pthread_cancel( controlHandle );
-    pthread_join( controlHandle, NULL );
+// Wait for the thread of the given manipulator to exit and return its exiting value
+uint32_t Thread_WaitExit( Thread handle, unsigned int milliseconds )
+{
+  struct timespec timeout;
+  void* result = NULL;
 
-    pthread_cond_destroy( &(controlArgs.condition) );
-    pthread_mutex_destroy( &(controlArgs.lock) );
+  if( handle == THREAD_INVALID_HANDLE ) return 0;
   
-    if( controlArgs.result != NULL ) return *((uint32_t*) (controlArgs.result));
-    
-    free( handle );
+  if( milliseconds != INFINITE )
+  {
+    clock_gettime( CLOCK_REALTIME, &timeout );
+    timeout.tv_sec += (time_t) ( milliseconds / 1000 );
+    timeout.tv_nsec += (long) 1000000 * ( milliseconds % 1000 );
+    timeout.tv_sec += timeout.tv_nsec / 1000000000;
+    timeout.tv_nsec %= 1000000000;
   }
+  
+  // On timeout the thread is still joinable, so its handle is kept
+  if( !JoinThread( *((pthread_t*) handle), ( milliseconds == INFINITE ) ? NULL : &timeout, &result ) ) return 0;
+  
+  free( handle );
+  
+  if( result != NULL ) return *((uint32_t*) result);
 
   return 0;
 }
@@ -169,4 +475,148 @@ unsigned long Thread_GetID()
   return (unsigned long) pthread_self();
 }
 
+#ifdef __linux__
+
+// Find NUMA node of given processor, from its "nodeX" sysfs entry
+static int GetCPUNode( size_t cpuIndex )
+{
+  char cpuPath[ PATH_MAX ];
+  snprintf( cpuPath, PATH_MAX, "/sys/devices/system/cpu/cpu%lu", (unsigned long) cpuIndex );
+  
+  DIR* cpuDirectory = opendir( cpuPath );
+  if( cpuDirectory == NULL ) return 0;
+  
+  int numaNode = 0;
+  struct dirent* entry;
+  while( (entry = readdir( cpuDirectory )) != NULL )
+  {
+    if( sscanf( entry->d_name, "node%d", &numaNode ) == 1 ) break;
+  }
+  closedir( cpuDirectory );
+  
+  return numaNode;
+}
+
+size_t Thread_GetTopology( ThreadCPUInfo* cpus, size_t maxCount )
+{
+  uint64_t onlineMask[ THREAD_MAX_CPUS / 64 ] = { 0 };
+  if( !ReadCPUList( "/sys/devices/system/cpu/online", onlineMask ) )
+  {
+    long onlineCount = sysconf( _SC_NPROCESSORS_ONLN );
+    for( long cpuIndex = 0; cpuIndex < onlineCount && cpuIndex < THREAD_MAX_CPUS; cpuIndex++ )
+      onlineMask[ cpuIndex / 64 ] |= ( (uint64_t) 1 << ( cpuIndex % 64 ) );
+  }
+  
+  size_t cpusCount = 0;
+  for( size_t cpuIndex = 0; cpuIndex < THREAD_MAX_CPUS; cpuIndex++ )
+  {
+    if( !( onlineMask[ cpuIndex / 64 ] & ( (uint64_t) 1 << ( cpuIndex % 64 ) ) ) ) continue;
+    
+    if( cpus != NULL && cpusCount < maxCount )
+    {
+      char topologyPath[ PATH_MAX ];
+      ThreadCPUInfo* cpuInfo = &(cpus[ cpusCount ]);
+      cpuInfo->cpuIndex = cpuIndex;
+      snprintf( topologyPath, PATH_MAX, "/sys/devices/system/cpu/cpu%lu/topology/core_id", (unsigned long) cpuIndex );
+      cpuInfo->coreIndex = (size_t) ReadSysValue( topologyPath, (long) cpuIndex );
+      snprintf( topologyPath, PATH_MAX, "/sys/devices/system/cpu/cpu%lu/topology/physical_package_id", (unsigned long) cpuIndex );
+      cpuInfo->packageIndex = (size_t) ReadSysValue( topologyPath, 0 );
+      // SMT siblings are numbered by their position on the core siblings list
+      uint64_t siblingsMask[ THREAD_MAX_CPUS / 64 ] = { 0 };
+      snprintf( topologyPath, PATH_MAX, "/sys/devices/system/cpu/cpu%lu/topology/thread_siblings_list", (unsigned long) cpuIndex );
+      cpuInfo->siblingIndex = 0;
+      if( ReadCPUList( topologyPath, siblingsMask ) )
+      {
+        for( size_t siblingIndex = 0; siblingIndex < cpuIndex; siblingIndex++ )
+        {
+          if( siblingsMask[ siblingIndex / 64 ] & ( (uint64_t) 1 << ( siblingIndex % 64 ) ) ) cpuInfo->siblingIndex++;
+        }
+      }
+      cpuInfo->numaNode = GetCPUNode( cpuIndex );
+    }
+    
+    cpusCount++;
+  }
+  
+  return cpusCount;
+}
+
+#else
+
+// Without sysfs, each online processor is taken as a separate core on the same package and node
+size_t Thread_GetTopology( ThreadCPUInfo* cpus, size_t maxCount )
+{
+  long onlineCount = sysconf( _SC_NPROCESSORS_ONLN );
+  size_t cpusCount = ( onlineCount > 0 ) ? (size_t) onlineCount : 1;
+  for( size_t cpuIndex = 0; cpuIndex < cpusCount && cpus != NULL && cpuIndex < maxCount; cpuIndex++ )
+  {
+    ThreadCPUInfo cpuInfo = { .cpuIndex = cpuIndex, .coreIndex = cpuIndex, .packageIndex = 0, .siblingIndex = 0, .numaNode = 0 };
+    cpus[ cpuIndex ] = cpuInfo;
+  }
+  
+  return cpusCount;
+}
+
+#include "thread_atomics.h"
+
+#define WAIT_BUCKETS_COUNT 64
+
+// Waiters on any address of the same hash share a bucket, so wakes always broadcast and awaken threads recheck their words
+typedef struct _WaitBucket
+{
+  pthread_mutex_t lock;
+  pthread_cond_t changed;
+}
+WaitBucket;
+
+static WaitBucket waitBuckets[ WAIT_BUCKETS_COUNT ] = { [ 0 ... WAIT_BUCKETS_COUNT - 1 ] = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER } };
+
+static WaitBucket* GetWaitBucket( volatile uint32_t* address )
+{
+  uintptr_t hash = (uintptr_t) address / sizeof(uint32_t);
+  return &(waitBuckets[ ( hash ^ ( hash >> 6 ) ^ ( hash >> 12 ) ) % WAIT_BUCKETS_COUNT ]);
+}
+
+// Blocks calling thread while given memory word holds the expected value (see Atomic_Wait())
+bool Atomic_WaitThread( volatile uint32_t* address, uint32_t expected, uint64_t deadline )
+{
+  WaitBucket* bucket = GetWaitBucket( address );
+  int waitStatus = 0;
+  
+  // Value is checked under the bucket lock, also taken by wakers after their stores, so no wake is lost
+  pthread_mutex_lock( &(bucket->lock) );
+  if( __atomic_load_n( address, __ATOMIC_SEQ_CST ) == expected )
+  {
+    if( deadline == ATOMIC_TIME_INFINITE )
+      waitStatus = pthread_cond_wait( &(bucket->changed), &(bucket->lock) );
+    else
+    {
+      // Condition variables time out on the realtime clock, so the remaining monotonic time is added to it
+      uint64_t now = Atomic_GetTime();
+      struct timespec timeout;
+      clock_gettime( CLOCK_REALTIME, &timeout );
+      uint64_t wakeTime = (uint64_t) timeout.tv_sec * 1000000000 + (uint64_t) timeout.tv_nsec + ( ( deadline > now ) ? deadline - now : 0 );
+      timeout.tv_sec = (time_t) ( wakeTime / 1000000000 );
+      timeout.tv_nsec = (long) ( wakeTime % 1000000000 );
+      waitStatus = pthread_cond_timedwait( &(bucket->changed), &(bucket->lock), &timeout );
+    }
+  }
+  pthread_mutex_unlock( &(bucket->lock) );
+  
+  return ( waitStatus != ETIMEDOUT );
+}
+
+// Awakes threads blocked on changes of given memory word (see Atomic_Wake())
+void Atomic_WakeThreads( volatile uint32_t* address, bool all )
+{
+  (void) all;
+  WaitBucket* bucket = GetWaitBucket( address );
+  
+  pthread_mutex_lock( &(bucket->lock) );
+  pthread_cond_broadcast( &(bucket->changed) );
+  pthread_mutex_unlock( &(bucket->lock) );
+}
+
+#endif // __linux__
+
 #endif // WIN32
@@ -33,6 +33,8 @@
 #include <stddef.h>
 
 #define THREAD_INVALID_HANDLE NULL            ///< Handle to be returned on thread creation errors
+#define THREAD_MAX_CPUS 1024                  ///< Maximum number of logical processors addressable by thread affinity masks
+#define THREAD_NUMA_ANY -1                    ///< No preferred NUMA node
 #ifndef INFINITE
   #define INFINITE 0xFFFFFFFF                 ///< Infinite waiting time
 #endif
@@ -44,17 +46,65 @@ enum ThreadResourceMode
        THREAD_JOINABLE       ///< Thread termination will be awaited (for synchornization) with WaitExit() before its allocated resources are freed 
 };
        
+/// Scheduling policy of created threads
+enum ThreadSchedulingPolicy
+{
+       THREAD_SCHED_DEFAULT,    ///< Operating system default (time-sharing) scheduling
+       THREAD_SCHED_FIFO,       ///< Real-time first-in first-out scheduling (SCHED_FIFO on POSIX)
+       THREAD_SCHED_RR          ///< Real-time round-robin scheduling (SCHED_RR on POSIX)
+};
+       
 typedef void* Thread;                       ///< Opaque alias for platform specific thread handle type
 typedef void* (*AsyncFunction)( void* );    ///< Signature/type required for functions offloaded to another thread
 
+/// Extended thread creation attributes (should be initialized with Thread_InitAttributes())
+typedef struct _ThreadAttributes
+{
+  uint64_t affinityMask[ THREAD_MAX_CPUS / 64 ];    ///< Bit mask of logical processors allowed to run the thread (all zeros for no restriction, thread creation fails if not supported, e.g. beyond the process processor group on Windows)
+  size_t stackSize;                                 ///< Stack size (in bytes) of the thread (0 for system default)
+  enum ThreadSchedulingPolicy schedulingPolicy;     ///< Scheduling policy of the thread
+  int priority;                                     ///< Real-time priority of the thread (for THREAD_SCHED_FIFO and THREAD_SCHED_RR policies, 1-99 mapped to above normal, highest and time critical levels on Windows)
+  const char* name;                                 ///< Thread name shown by debuggers/tools (NULL for none, may be truncated, only set on Linux)
+  int numaNode;                                     ///< Preferred NUMA node for thread processors and memory (THREAD_NUMA_ANY for none, only applied on Linux)
+}
+ThreadAttributes;
+
+/// Position of a logical processor on the system topology
+typedef struct _ThreadCPUInfo
+{
+  size_t cpuIndex;          ///< Logical processor index (as used by affinity masks)
+  size_t coreIndex;         ///< Physical core identifier (shared by SMT siblings, unique only inside its package)
+  size_t packageIndex;      ///< Physical package (socket) identifier
+  size_t siblingIndex;      ///< Index of the hardware thread among its SMT siblings on the same core
+  int numaNode;             ///< NUMA node of the processor (0 on non-NUMA systems)
+}
+ThreadCPUInfo;
+
                                                                             
 /// @brief Setups new thread to run the given method asynchronously                                               
 /// @param[in] function pointer to the function that will run on spawned thread                                   
 /// @param[in] args opaque pointer to struct that will be passed as the thread function argument                                         
 /// @param[in] mode resources management option (THREAD_DETACHED or THREAD_JOINABLE)       
-/// @return Handle to the newly created thread (THREAD_INVALID_HANDLE on errors)  
+/// @return Handle to the newly created thread (THREAD_INVALID_HANDLE on errors, only usable for this check on detached threads)  
 Thread Thread_Start( void* (*function)( void* ), void* args, enum ThreadResourceMode mode );
 
+/// @brief Sets given thread attributes to system defaults (no affinity, default stack size and scheduling, no name or NUMA node)
+/// @param[out] attributes pointer to attributes structure
+void Thread_InitAttributes( ThreadAttributes* attributes );
+
+/// @brief Allows logical processor of given index to run threads created with given attributes
+/// @param[in,out] attributes pointer to attributes structure
+/// @param[in] cpuIndex logical processor index (less than THREAD_MAX_CPUS)
+void Thread_AddAffinityCPU( ThreadAttributes* attributes, size_t cpuIndex );
+
+/// @brief Setups new thread, with given extended attributes, to run the given method asynchronously                                               
+/// @param[in] function pointer to the function that will run on spawned thread                                   
+/// @param[in] args opaque pointer to struct that will be passed as the thread function argument                                         
+/// @param[in] mode resources management option (THREAD_DETACHED or THREAD_JOINABLE)       
+/// @param[in] attributes pointer to creation attributes (NULL for system defaults)       
+/// @return Handle to the newly created thread (THREAD_INVALID_HANDLE on errors, e.g. missing privileges for real-time scheduling, only usable for this check on detached threads)  
+Thread Thread_StartEx( void* (*function)( void* ), void* args, enum ThreadResourceMode mode, const ThreadAttributes* attributes );
+
 /// @brief Waits for the thread of the given manipulator to exit and return its exiting value                              
 /// @param[in] handle handle to a joinable (started with THREAD_JOINABLE) thread
 /// @param[in] milliseconds timeout (in milliseconds) for thread termination waiting (INFINITE to wait indefinitely)       
@@ -65,4 +115,10 @@ uint32_t Thread_WaitExit( Thread handle, unsigned int milliseconds );
 /// @return calling thread platform specific identifier 
 unsigned long Thread_GetID();
 
+/// @brief Queries processors topology of the system (cores, SMT siblings and NUMA nodes, only known on Linux: other systems list each processor as a separate core)
+/// @param[out] cpus array for storing information of each online logical processor (NULL to only count them)
+/// @param[in] maxCount maximum number of elements written to the array
+/// @return number of online logical processors
+size_t Thread_GetTopology( ThreadCPUInfo* cpus, size_t maxCount );
+
 #endif // THREADS_H